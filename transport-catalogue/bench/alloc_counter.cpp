@@ -0,0 +1,39 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.h"
+
+namespace {
+	std::atomic<size_t> alloc_count{ 0 };
+	std::atomic<size_t> alloc_bytes{ 0 };
+}
+
+void* operator new(std::size_t size) {
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+namespace bench {
+
+	AllocStats GetAllocStats() {
+		return { alloc_count.load(std::memory_order_relaxed), alloc_bytes.load(std::memory_order_relaxed) };
+	}
+
+	AllocStats operator-(const AllocStats& lhs, const AllocStats& rhs) {
+		return { lhs.count - rhs.count, lhs.bytes - rhs.bytes };
+	}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+namespace bench {
+
+	struct AllocStats {
+		size_t count = 0;
+		size_t bytes = 0;
+	};
+
+	// counters of the global operator new, shared by the whole benchmark binary
+	AllocStats GetAllocStats();
+
+	AllocStats operator-(const AllocStats& lhs, const AllocStats& rhs);
+
+}
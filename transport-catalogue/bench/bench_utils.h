@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "alloc_counter.h"
+
+namespace bench {
+
+	// measures wall time and allocations between construction and Report()
+	class Measure {
+	public:
+		explicit Measure(std::string name)
+			: name_(std::move(name)), start_(std::chrono::steady_clock::now()), allocs_(GetAllocStats())
+		{}
+
+		void Report(size_t items, std::ostream& out = std::cout) const {
+			const auto elapsed = std::chrono::steady_clock::now() - start_;
+			const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+			const AllocStats allocs = GetAllocStats() - allocs_;
+			out << name_ << ": items=" << items << " time_ms=" << ms
+				<< " ns_per_item=" << (items ? ms * 1e6 / items : 0.0)
+				<< " allocs=" << allocs.count << " alloc_bytes=" << allocs.bytes
+				<< " allocs_per_item=" << (items ? static_cast<double>(allocs.count) / items : 0.0) << std::endl;
+		}
+
+	private:
+		std::string name_;
+		std::chrono::steady_clock::time_point start_;
+		AllocStats allocs_;
+	};
+
+	// stream buffer that drops the output and only counts it, stands in for stdout
+	class CountingBuffer : public std::streambuf {
+	public:
+		size_t GetSize() const {
+			return size_;
+		}
+
+	protected:
+		std::streamsize xsputn(const char*, std::streamsize count) override {
+			size_ += static_cast<size_t>(count);
+			return count;
+		}
+
+		int_type overflow(int_type c) override {
+			if (!traits_type::eq_int_type(c, traits_type::eof())) {
+				++size_;
+			}
+			return traits_type::not_eof(c);
+		}
+
+	private:
+		size_t size_ = 0;
+	};
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "../img/map_renderer.h"
+
+namespace bench {
+
+	RenderSettings MakeRenderSettings();
+
+	void RunJsonBuilderBench(size_t answers);
+	//renders a synthetic network with the given number of stops and stops/10 buses
+	void RunRenderBench(size_t stops);
+	//renders the whole map of a network with local routes at several simplification tolerances
+	void RunSimplifyBench(size_t stops);
+	//renders the same network with inline attributes and with a shared style sheet
+	void RunStylesBench(size_t stops);
+	//renders a map and prints it as a JSON string, copying the map into a node or escaping it in place
+	void RunMapJsonBench(size_t stops);
+	//renders the base map and three themes separately and over one shared scene
+	void RunThemesBench(size_t stops);
+	//renders viewports of a synthetic network from the whole city down to 1/4096 of its area
+	void RunViewportBench(size_t stops);
+	//builds and serializes an svg::Document of polylines, circles and text labels
+	void RunSvgBench(size_t elements);
+	//times every phase of transport_catalog on a generated city, args are key=value pairs
+	void RunEndToEndBench(const std::vector<std::string_view>& args);
+	//compares the memory estimates of each subsystem with the allocations made while building it
+	void RunMemoryBench(const std::vector<std::string_view>& args);
+	//builds the router with each strategy and answers the same route queries, requests=n sets their number
+	void RunRouterBench(const std::vector<std::string_view>& args);
+	//prints the generated input document of the same city
+	void GenerateCity(const std::vector<std::string_view>& args, std::ostream& out);
+
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "city_generator.h"
+
+namespace bench {
+
+	namespace {
+
+		const double MIN_LAT = 55.5;
+		const double MAX_LAT = 55.9;
+		const double MIN_LNG = 37.3;
+		const double MAX_LNG = 37.9;
+
+		//horizontal strips of the city, left to right in even strips and right to left
+		//in odd ones, so neighbours in the order are neighbours on the map
+		void SortInSnakeOrder(std::vector<const Stop*>& stops) {
+			const double strips = std::max(1.0, std::floor(std::sqrt(static_cast<double>(stops.size()))));
+			auto key = [strips](const Stop* stop) {
+				const int strip = static_cast<int>((stop->coordiante.lat - MIN_LAT) / (MAX_LAT - MIN_LAT) * strips);
+				return std::make_pair(strip, strip % 2 ? -stop->coordiante.lng : stop->coordiante.lng);
+			};
+			std::sort(stops.begin(), stops.end(), [&key](const Stop* l, const Stop* r) {
+				return key(l) < key(r); });
+		}
+
+	}
+
+	void FillCatalogue(const CityParams& params, transportcatalogue::TransportCatalogue& tc) {
+		std::mt19937 gen(params.seed);
+		std::uniform_real_distribution<double> lat(MIN_LAT, MAX_LAT);
+		std::uniform_real_distribution<double> lng(MIN_LNG, MAX_LNG);
+		std::uniform_int_distribution<size_t> stop_id(0, params.stops - 1);
+		std::uniform_int_distribution<int> distance(300, 3000);
+		std::bernoulli_distribution roundtrip(params.roundtrip_ratio);
+
+		std::vector<const Stop*> stops;
+		stops.reserve(params.stops);
+		for (size_t i = 0; i != params.stops; ++i) {
+			tc.AddStop("Stop " + std::to_string(i), { lat(gen), lng(gen) });
+			stops.emplace_back(&tc.GetStops().back());
+		}
+
+		if (params.route_window) {
+			SortInSnakeOrder(stops);
+		}
+		std::uniform_int_distribution<long> step(-static_cast<long>(params.route_window), static_cast<long>(params.route_window));
+
+		std::vector<const Stop*> route;
+		for (size_t i = 0; i != params.buses; ++i) {
+			const bool is_roundtrip = roundtrip(gen);
+			route.clear();
+			size_t position = 0;
+			for (size_t j = 0; j != params.stops_per_bus; ++j) {
+				if (j == 0 || !params.route_window) {
+					position = stop_id(gen);
+				}
+				else {
+					const long next = static_cast<long>(position) + step(gen);
+					position = static_cast<size_t>(std::clamp(next, 0L, static_cast<long>(stops.size()) - 1));
+				}
+				route.emplace_back(stops[position]);
+			}
+			if (is_roundtrip) {
+				route.emplace_back(route.front());
+			}
+			for (size_t j = 0; j + 1 < route.size(); ++j) {
+				tc.SetDistance(route[j], route[j + 1], distance(gen));
+			}
+			if (!is_roundtrip) {
+				for (size_t j = route.size() - 1; j != 0; --j) {
+					route.emplace_back(route[j - 1]);
+				}
+			}
+			tc.AddBus("Bus " + std::to_string(i), is_roundtrip, route);
+		}
+
+		for (size_t i = 0; i != params.stops * params.extra_distances; ++i) {
+			const Stop* from = stops[i / params.extra_distances];
+			const Stop* to = stops[stop_id(gen)];
+			if (from != to) {
+				tc.SetDistance(from, to, distance(gen));
+			}
+		}
+	}
+
+	json::Document GenerateCityDocument(const CityParams& params, const RequestMix& mix) {
+		using namespace std::literals;
+		transportcatalogue::TransportCatalogue tc;
+		FillCatalogue(params, tc);
+
+		std::map<std::string_view, json::Dict> road_distances;
+		for (const auto& [stops, distance] : tc.GetDistances()) {
+			road_distances[stops.first].emplace(std::string(stops.second), distance);
+		}
+
+		json::Array base;
+		base.reserve(tc.GetStops().size() + tc.GetBuses().size());
+		for (const Stop& stop : tc.GetStops()) {
+			base.emplace_back(json::Dict{
+				{ "type"s, "Stop"s },
+				{ "name"s, stop.name },
+				{ "latitude"s, stop.coordiante.lat },
+				{ "longitude"s, stop.coordiante.lng },
+				{ "road_distances"s, std::move(road_distances[stop.name]) },
+			});
+		}
+		for (const Bus& bus : tc.GetBuses()) {
+			//the catalogue keeps the way back of a linear route, the input only the way there
+			const size_t count = bus.is_roundtrip ? bus.stops.size() : bus.stops.size() / 2 + 1;
+			json::Array stops;
+			stops.reserve(count);
+			for (size_t i = 0; i != count; ++i) {
+				stops.emplace_back(bus.stops[i]->name);
+			}
+			base.emplace_back(json::Dict{
+				{ "type"s, "Bus"s },
+				{ "name"s, bus.name },
+				{ "stops"s, std::move(stops) },
+				{ "is_roundtrip"s, bus.is_roundtrip },
+			});
+		}
+
+		std::mt19937 gen(mix.seed);
+		std::discrete_distribution<int> type({ mix.bus, mix.stop, mix.route, mix.map });
+		std::uniform_int_distribution<size_t> stop_id(0, tc.GetStops().size() - 1);
+		std::uniform_int_distribution<size_t> bus_id(0, std::max<size_t>(tc.GetBuses().size(), 1) - 1);
+		json::Array requests;
+		requests.reserve(mix.requests);
+		for (size_t i = 0; i != mix.requests; ++i) {
+			json::Dict request{ { "id"s, static_cast<int>(i) } };
+			switch (type(gen)) {
+			case 0:
+				request.emplace("type"s, "Bus"s);
+				request.emplace("name"s, tc.GetBuses().empty() ? "Bus 0"s : tc.GetBuses()[bus_id(gen)].name);
+				break;
+			case 1:
+				request.emplace("type"s, "Stop"s);
+				request.emplace("name"s, tc.GetStops()[stop_id(gen)].name);
+				break;
+			case 2:
+				request.emplace("type"s, "Route"s);
+				request.emplace("from"s, tc.GetStops()[stop_id(gen)].name);
+				request.emplace("to"s, tc.GetStops()[stop_id(gen)].name);
+				break;
+			default:
+				request.emplace("type"s, "Map"s);
+				break;
+			}
+			requests.emplace_back(std::move(request));
+		}
+
+		json::Dict render_settings{
+			{ "width"s, 1200.0 }, { "height"s, 1200.0 }, { "padding"s, 50.0 },
+			{ "stop_radius"s, 5.0 }, { "line_width"s, 14.0 },
+			{ "bus_label_font_size"s, 20 }, { "bus_label_offset"s, json::Array{ 7.0, 15.0 } },
+			{ "stop_label_font_size"s, 20 }, { "stop_label_offset"s, json::Array{ 7.0, -3.0 } },
+			{ "underlayer_color"s, json::Array{ 255, 255, 255, 0.85 } }, { "underlayer_width"s, 3.0 },
+			{ "color_palette"s, json::Array{ "green"s, json::Array{ 255, 160, 0 }, "red"s } },
+		};
+		json::Dict routing_settings{ { "bus_wait_time"s, 6 }, { "bus_velocity"s, 40.0 } };
+
+		return json::Document{ json::Dict{
+			{ "base_requests"s, std::move(base) },
+			{ "render_settings"s, std::move(render_settings) },
+			{ "routing_settings"s, std::move(routing_settings) },
+			{ "stat_requests"s, std::move(requests) },
+		} };
+	}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+#include "../data/transport_catalogue.h"
+#include "../json/json.h"
+
+namespace bench {
+
+	struct CityParams {
+		size_t stops = 10000;
+		size_t buses = 1000;
+		size_t stops_per_bus = 20;
+		double roundtrip_ratio = 0.5;
+		uint32_t seed = 42;
+		//when set, every next stop of a route is one of the route_window stops nearest
+		//to the previous one along a snake order of the city, as in a real network;
+		//otherwise route stops are picked anywhere in the city
+		size_t route_window = 0;
+		//road distances from every stop to random stops on top of the ones along the routes
+		size_t extra_distances = 0;
+	};
+
+	//shares of stat request types, they don't have to sum up to 1
+	struct RequestMix {
+		size_t requests = 10000;
+		double bus = 0.3;
+		double stop = 0.3;
+		double route = 0.35;
+		double map = 0.002;
+		uint32_t seed = 7;
+	};
+
+	// Fills the catalogue with a seeded random network, stops are scattered over a
+	// city-sized area and every route stop has a road distance to the next one
+	void FillCatalogue(const CityParams& params, transportcatalogue::TransportCatalogue& tc);
+
+	// Builds a complete input document for transport_catalog: the network of FillCatalogue
+	// as base_requests, render and routing settings, and seeded stat_requests of the mix
+	json::Document GenerateCityDocument(const CityParams& params, const RequestMix& mix);
+
+}
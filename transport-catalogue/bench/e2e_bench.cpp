@@ -0,0 +1,265 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "alloc_counter.h"
+#include "benchmarks.h"
+#include "bench_utils.h"
+#include "city_generator.h"
+#include "../json/json_reader.h"
+#include "../main/request_handler.h"
+#include "../util/memory_usage.h"
+
+namespace bench {
+
+	namespace {
+
+		struct EndToEndParams {
+			CityParams city;
+			RequestMix mix;
+		};
+
+		//the router keeps a table for every pair of stops, so the default city is small
+		EndToEndParams MakeDefaultParams() {
+			EndToEndParams params;
+			params.city.stops = 500;
+			params.city.buses = 150;
+			params.city.stops_per_bus = 10;
+			params.city.route_window = 8;
+			params.city.extra_distances = 2;
+			params.mix.requests = 50000;
+			return params;
+		}
+
+		EndToEndParams ParseParams(const std::vector<std::string_view>& args, EndToEndParams params = MakeDefaultParams()) {
+			using namespace std::literals;
+			for (const std::string_view arg : args) {
+				const size_t eq = arg.find('=');
+				if (eq == std::string_view::npos) {
+					throw std::invalid_argument("expected key=value, got "s + std::string(arg));
+				}
+				const std::string_view key = arg.substr(0, eq);
+				const std::string value(arg.substr(eq + 1));
+				if (key == "stops"sv) {
+					params.city.stops = std::stoull(value);
+				}
+				else if (key == "buses"sv) {
+					params.city.buses = std::stoull(value);
+				}
+				else if (key == "stops_per_bus"sv) {
+					params.city.stops_per_bus = std::stoull(value);
+				}
+				else if (key == "roundtrip"sv) {
+					params.city.roundtrip_ratio = std::stod(value);
+				}
+				else if (key == "window"sv) {
+					params.city.route_window = std::stoull(value);
+				}
+				else if (key == "distances"sv) {
+					params.city.extra_distances = std::stoull(value);
+				}
+				else if (key == "seed"sv) {
+					params.city.seed = static_cast<uint32_t>(std::stoul(value));
+					params.mix.seed = params.city.seed + 1;
+				}
+				else if (key == "requests"sv) {
+					params.mix.requests = std::stoull(value);
+				}
+				else if (key == "bus"sv) {
+					params.mix.bus = std::stod(value);
+				}
+				else if (key == "stop"sv) {
+					params.mix.stop = std::stod(value);
+				}
+				else if (key == "route"sv) {
+					params.mix.route = std::stod(value);
+				}
+				else if (key == "map"sv) {
+					params.mix.map = std::stod(value);
+				}
+				else {
+					throw std::invalid_argument("unknown parameter "s + std::string(key));
+				}
+			}
+			if (params.city.stops == 0 || params.city.stops_per_bus < 2) {
+				throw std::invalid_argument("the city needs stops and at least 2 stops per bus"s);
+			}
+			return params;
+		}
+
+		void PrintParams(const EndToEndParams& params, std::ostream& out) {
+			out << "stops=" << params.city.stops << " buses=" << params.city.buses
+				<< " stops_per_bus=" << params.city.stops_per_bus << " roundtrip=" << params.city.roundtrip_ratio
+				<< " window=" << params.city.route_window << " distances=" << params.city.extra_distances
+				<< " seed=" << params.city.seed << " requests=" << params.mix.requests
+				<< " mix=" << params.mix.bus << '/' << params.mix.stop << '/' << params.mix.route << '/' << params.mix.map
+				<< std::endl;
+		}
+
+		//the estimate of a structure next to what was allocated while it was built; temporaries
+		//and the copies left behind by growing containers make the second one larger
+		void PrintMemory(std::string_view name, const util::MemoryUsage& estimate, const AllocStats& allocated) {
+			std::cout << "memory " << name << ": estimated_bytes=" << estimate.bytes
+				<< " estimated_allocs=" << estimate.allocations << " allocated_bytes=" << allocated.bytes
+				<< " allocs=" << allocated.count << " share=" << (allocated.bytes ? static_cast<double>(estimate.bytes) / allocated.bytes : 0.0)
+				<< std::endl;
+		}
+
+	}
+
+	void GenerateCity(const std::vector<std::string_view>& args, std::ostream& out) {
+		const EndToEndParams params = ParseParams(args);
+		json::Print(GenerateCityDocument(params.city, params.mix), out);
+	}
+
+	void RunEndToEndBench(const std::vector<std::string_view>& args) {
+		const EndToEndParams params = ParseParams(args);
+		PrintParams(params, std::cout);
+
+		std::string input;
+		{
+			Measure measure("e2e_generate");
+			std::ostringstream text;
+			json::Print(GenerateCityDocument(params.city, params.mix), text);
+			input = text.str();
+			measure.Report(params.mix.requests);
+		}
+		std::cout << "input_bytes=" << input.size() << std::endl;
+
+		//the same phases as transport_catalog < input.json, each timed on its own
+		Measure total("e2e_total");
+		std::istringstream input_stream(input);
+		Measure load("e2e_json_load");
+		const json::Document doc = json::Load(input_stream);
+		load.Report(input.size());
+
+		Measure catalogue("e2e_catalogue");
+		const JSONReader reader(doc);
+		catalogue.Report(params.city.stops + params.city.buses);
+
+		const std::vector<RequestList> requests = reader.GetRequestList();
+		Measure answer("e2e_answer");
+		CountingBuffer buffer;
+		std::ostream out(&buffer);
+		{
+			const RequestHandler handler(reader.GetTransportCatalague(), requests,
+				reader.GetRenderSettings(), reader.GetRenderThemes(), reader.GetRoutSetting());
+			handler.AnswerOnRequests(out);
+		}
+		answer.Report(requests.size());
+		total.Report(requests.size());
+		std::cout << "output_bytes=" << buffer.GetSize() << std::endl;
+
+		//the lazily built parts of the answer phase, measured apart from the requests
+		{
+			Measure router("e2e_router_build");
+			const TransportRouter tr(reader.GetTransportCatalague(), reader.GetRoutSetting());
+			router.Report(params.city.stops);
+		}
+		{
+			Measure render("e2e_map_render");
+			const renderer::MapRenderer mr(reader.GetRenderSettings());
+			std::vector<const Bus*> buses = reader.GetTransportCatalague().GetBusesVector();
+			const std::string map = mr.PrintBusRoutes(buses);
+			render.Report(params.city.stops);
+		}
+	}
+
+	void RunMemoryBench(const std::vector<std::string_view>& args) {
+		//without stat_requests the reader builds little besides the catalogue
+		EndToEndParams defaults = MakeDefaultParams();
+		defaults.mix.requests = 0;
+		const EndToEndParams params = ParseParams(args, defaults);
+		PrintParams(params, std::cout);
+
+		std::ostringstream text;
+		json::Print(GenerateCityDocument(params.city, params.mix), text);
+		std::istringstream input(text.str());
+
+		AllocStats start = GetAllocStats();
+		const json::Document doc = json::Load(input);
+		PrintMemory("json_document", json::GetMemoryUsage(doc.GetRoot()), GetAllocStats() - start);
+
+		start = GetAllocStats();
+		const JSONReader reader(doc);
+		const auto& catalogue = reader.GetTransportCatalague();
+		PrintMemory("catalogue", catalogue.GetMemoryUsage(), GetAllocStats() - start);
+
+		start = GetAllocStats();
+		const TransportRouter router(catalogue, reader.GetRoutSetting());
+		const AllocStats router_allocs = GetAllocStats() - start;
+		util::MemoryUsage router_memory = router.GetGraphMemory();
+		router_memory += router.GetTableMemory();
+		router_memory += router.GetMetadataMemory();
+		PrintMemory("router", router_memory, router_allocs);
+
+		const renderer::MapRenderer renderer(reader.GetRenderSettings());
+		start = GetAllocStats();
+		renderer::MapScene scene = renderer.CreateScene(catalogue.GetBusesVector());
+		renderer.IndexScene(scene);
+		PrintMemory("map_scene", scene.GetMemoryUsage(), GetAllocStats() - start);
+
+		start = GetAllocStats();
+		const json::EscapedString map(std::move(renderer.RenderThemes(scene).front()));
+		PrintMemory("map_output", map.GetMemoryUsage(), GetAllocStats() - start);
+	}
+
+	void RunRouterBench(const std::vector<std::string_view>& args) {
+		EndToEndParams defaults = MakeDefaultParams();
+		defaults.mix.requests = 0;
+		EndToEndParams params = ParseParams(args, defaults);
+		//the number of route queries, the other requests are not generated
+		const size_t queries = params.mix.requests ? params.mix.requests : 10000;
+		params.mix.requests = 0;
+		PrintParams(params, std::cout);
+
+		const JSONReader reader(GenerateCityDocument(params.city, params.mix));
+		const auto& catalogue = reader.GetTransportCatalague();
+		const auto& stops = catalogue.GetStops();
+		std::mt19937 gen(params.mix.seed);
+		std::uniform_int_distribution<size_t> stop_id(0, stops.size() - 1);
+		std::vector<std::pair<std::string_view, std::string_view>> pairs(queries);
+		for (auto& [from, to] : pairs) {
+			from = stops[stop_id(gen)].name;
+			to = stops[stop_id(gen)].name;
+		}
+
+		//both strategies answer the same queries, the total time of the routes must match
+		double totals[2] = { 0, 0 };
+		size_t found[2] = { 0, 0 };
+		size_t edges = 0;
+		const RouterStrategy strategies[] = { RouterStrategy::AllPairs, RouterStrategy::PerQuery };
+		for (size_t i = 0; i != 2; ++i) {
+			RouteSetting settings = reader.GetRoutSetting();
+			settings.strategy = strategies[i];
+			const std::string name(GetRouterStrategyName(strategies[i]));
+			Measure total("router_" + name);
+			Measure build("router_" + name + "_build");
+			const TransportRouter router(catalogue, settings, queries);
+			build.Report(stops.size());
+			edges = router.GetChoice().edges;
+			Measure answer("router_" + name + "_queries");
+			RouteResult result;
+			for (const auto& [from, to] : pairs) {
+				if (router.GetRouteMap(from, to, result)) {
+					++found[i];
+					for (const RouteItem& item : result.items) {
+						totals[i] += item.time;
+					}
+				}
+			}
+			answer.Report(queries);
+			total.Report(queries);
+		}
+		const RouterChoice choice = TransportRouter::ChooseStrategy(reader.GetRoutSetting(),
+			stops.size(), edges, queries);
+		std::cout << "routes_found=" << found[0] << '/' << found[1]
+			<< " same_times=" << (found[0] == found[1] && std::abs(totals[0] - totals[1]) < 1e-6 * (1 + totals[0]))
+			<< std::endl;
+		std::cout << "auto_choice=" << GetRouterStrategyName(choice.strategy) << " (" << choice.reason << ")" << std::endl;
+	}
+
+}
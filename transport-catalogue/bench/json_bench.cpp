@@ -0,0 +1,73 @@
+#include <string>
+
+#include "benchmarks.h"
+#include "bench_utils.h"
+#include "../json/json_builder.h"
+
+namespace bench {
+
+	namespace {
+
+		json::Node BuildStopAnswer(int id) {
+			using namespace std::literals;
+			json::Array buses;
+			for (int i = 0; i != 5; ++i) {
+				buses.emplace_back("bus number "s + std::to_string(i));
+			}
+			json::Builder builder;
+			builder.StartDict().Key("buses"s).Value(std::move(buses)).Key("request_id"s).Value(id).EndDict();
+			return std::move(builder).Build();
+		}
+
+		json::Node BuildBusAnswer(int id) {
+			using namespace std::literals;
+			json::Builder builder;
+			builder.StartDict()
+				.Key("curvature"s).Value(1.42963)
+				.Key("request_id"s).Value(id)
+				.Key("route_length"s).Value(5990)
+				.Key("stop_count"s).Value(4)
+				.Key("unique_stop_count"s).Value(3)
+				.EndDict();
+			return std::move(builder).Build();
+		}
+
+		json::Node BuildRouteAnswer(int id) {
+			using namespace std::literals;
+			json::Builder builder;
+			auto items = builder.StartDict().Key("items"s).StartArray();
+			for (int i = 0; i != 3; ++i) {
+				items.StartDict().Key("stop_name"s).Value("stop with a long enough name"s)
+					.Key("time"s).Value(6).Key("type"s).Value("Wait"s).EndDict();
+				items.StartDict().Key("bus"s).Value("bus with a long enough name"s)
+					.Key("span_count"s).Value(2).Key("time"s).Value(7.5).Key("type"s).Value("Bus"s).EndDict();
+			}
+			items.EndArray().Key("request_id"s).Value(id).Key("total_time"s).Value(40.5).EndDict();
+			return std::move(builder).Build();
+		}
+
+	}
+
+	void RunJsonBuilderBench(size_t answers) {
+		json::Array response;
+		response.reserve(answers);
+
+		Measure measure("json_builder");
+		for (size_t i = 0; i != answers; ++i) {
+			const int id = static_cast<int>(i);
+			switch (i % 3) {
+			case 0:
+				response.emplace_back(BuildStopAnswer(id));
+				break;
+			case 1:
+				response.emplace_back(BuildBusAnswer(id));
+				break;
+			default:
+				response.emplace_back(BuildRouteAnswer(id));
+				break;
+			}
+		}
+		measure.Report(answers);
+	}
+
+}
@@ -0,0 +1,101 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "benchmarks.h"
+
+using namespace std::literals;
+
+namespace {
+
+	void PrintUsage(std::ostream& out) {
+		out << "Usage: transport_bench <json_builder|render|map_json|simplify|styles|themes|viewport|svg> [size]"sv << std::endl;
+		out << "       transport_bench <e2e|memory|router|generate> [key=value...]"sv << std::endl;
+		out << "  json_builder [answers]  build a response of 100k answers by default"sv << std::endl;
+		out << "  render [stops]          render synthetic networks of 10k, 100k and 1M stops by default"sv << std::endl;
+		out << "  map_json [stops]        render a 100k stop map into a JSON string by default"sv << std::endl;
+		out << "  simplify [stops]        render a 100k stop network with route simplification by default"sv << std::endl;
+		out << "  styles [stops]          compare inline and shared styles on a 100k stop network by default"sv << std::endl;
+		out << "  themes [stops]          render four themes of a 100k stop network by default"sv << std::endl;
+		out << "  viewport [stops]        render viewports of a 100k stop network by default"sv << std::endl;
+		out << "  svg [elements]          build and serialize 1M svg elements by default"sv << std::endl;
+		out << "  e2e [key=value...]      time every phase of a run on a generated city"sv << std::endl;
+		out << "  memory [key=value...]   compare memory estimates with the allocations of each subsystem"sv << std::endl;
+		out << "  router [key=value...]   compare the all-pairs table with a search per route query"sv << std::endl;
+		out << "  generate [key=value...] print the input document of the generated city"sv << std::endl;
+		out << "    keys: stops buses stops_per_bus roundtrip window distances seed requests bus stop route map"sv << std::endl;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		PrintUsage(std::cerr);
+		return 1;
+	}
+
+	const std::string_view mode = argv[1];
+	if (mode == "e2e"sv || mode == "memory"sv || mode == "router"sv || mode == "generate"sv) {
+		const std::vector<std::string_view> args(argv + 2, argv + argc);
+		try {
+			if (mode == "e2e"sv) {
+				bench::RunEndToEndBench(args);
+			}
+			else if (mode == "memory"sv) {
+				bench::RunMemoryBench(args);
+			}
+			else if (mode == "router"sv) {
+				bench::RunRouterBench(args);
+			}
+			else {
+				bench::GenerateCity(args, std::cout);
+			}
+		}
+		catch (const std::invalid_argument& e) {
+			std::cerr << e.what() << std::endl;
+			PrintUsage(std::cerr);
+			return 1;
+		}
+		return 0;
+	}
+
+	const size_t size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+
+	if (mode == "json_builder"sv) {
+		bench::RunJsonBuilderBench(size ? size : 100000);
+	}
+	else if (mode == "render"sv) {
+		if (size) {
+			bench::RunRenderBench(size);
+		}
+		else {
+			for (size_t stops : { 10000, 100000, 1000000 }) {
+				bench::RunRenderBench(stops);
+			}
+		}
+	}
+	else if (mode == "map_json"sv) {
+		bench::RunMapJsonBench(size ? size : 100000);
+	}
+	else if (mode == "simplify"sv) {
+		bench::RunSimplifyBench(size ? size : 100000);
+	}
+	else if (mode == "styles"sv) {
+		bench::RunStylesBench(size ? size : 100000);
+	}
+	else if (mode == "themes"sv) {
+		bench::RunThemesBench(size ? size : 100000);
+	}
+	else if (mode == "viewport"sv) {
+		bench::RunViewportBench(size ? size : 100000);
+	}
+	else if (mode == "svg"sv) {
+		bench::RunSvgBench(size ? size : 1000000);
+	}
+	else {
+		PrintUsage(std::cerr);
+		return 1;
+	}
+}
@@ -0,0 +1,212 @@
+#include <sstream>
+
+#include "benchmarks.h"
+#include "bench_utils.h"
+#include "city_generator.h"
+#include "../img/map_renderer.h"
+#include "../json/json.h"
+
+namespace bench {
+
+	RenderSettings MakeRenderSettings() {
+		using namespace std::literals;
+		RenderSettings rs;
+		rs.width = 1200;
+		rs.height = 1200;
+		rs.padding = 50;
+		rs.stop_radius = 5;
+		rs.line_width = 14;
+		rs.bus_label_font_size = 20;
+		rs.bus_label_offset = { 7, 15 };
+		rs.stop_label_font_size = 20;
+		rs.stop_label_offset = { 7, -3 };
+		rs.underlayer_color = svg::Rgba{ 255, 255, 255, 0.85 };
+		rs.underlayer_width = 3;
+		rs.color_palette = { "green"s, svg::Rgb{ 255, 160, 0 }, "red"s };
+		return rs;
+	}
+
+	void RunRenderBench(size_t stops) {
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		FillCatalogue(params, tc);
+
+		const renderer::MapRenderer mr(MakeRenderSettings());
+		std::vector<const Bus*> bus_list = tc.GetBusesVector();
+
+		Measure measure("render");
+		const std::string map = mr.PrintBusRoutes(bus_list);
+		measure.Report(stops);
+		std::cout << "map_bytes=" << map.size() << std::endl;
+	}
+
+	void RunSimplifyBench(size_t stops) {
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		params.route_window = 8;
+		FillCatalogue(params, tc);
+		std::vector<const Bus*> bus_list = tc.GetBusesVector();
+
+		for (double tolerance : { 0.0, 0.5, 1.0, 2.0 }) {
+			RenderSettings rs = MakeRenderSettings();
+			rs.simplify_tolerance = tolerance;
+			const renderer::MapRenderer mr(rs);
+
+			std::ostringstream name;
+			name << "simplify_" << tolerance;
+			Measure measure(name.str());
+			const std::string map = mr.PrintBusRoutes(bus_list);
+			measure.Report(stops);
+			std::cout << "map_bytes=" << map.size() << std::endl;
+		}
+	}
+
+	void RunStylesBench(size_t stops) {
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		FillCatalogue(params, tc);
+		std::vector<const Bus*> bus_list = tc.GetBusesVector();
+
+		for (bool shared_styles : { false, true }) {
+			RenderSettings rs = MakeRenderSettings();
+			rs.shared_styles = shared_styles;
+			const renderer::MapRenderer mr(rs);
+			const std::string suffix = shared_styles ? "shared" : "inline";
+
+			Measure render("styles_render_" + suffix);
+			const std::string map = mr.PrintBusRoutes(bus_list);
+			render.Report(stops);
+
+			//the map is sent as a JSON string, every quote and line break is escaped
+			Measure escape("styles_json_" + suffix);
+			std::ostringstream json_out;
+			json::Print(json::Document{ json::Node{ map } }, json_out);
+			escape.Report(stops);
+			std::cout << "map_bytes=" << map.size() << " json_bytes=" << json_out.str().size() << std::endl;
+		}
+	}
+
+	void RunMapJsonBench(size_t stops) {
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		FillCatalogue(params, tc);
+
+		const renderer::MapRenderer mr(MakeRenderSettings());
+		std::vector<const Bus*> bus_list = tc.GetBusesVector();
+		//both paths start from a rendered map, only the way to the output is measured
+		std::string map = mr.PrintBusRoutes(bus_list);
+		std::string map_copy = map;
+
+		{
+			//the map copied into a string node and escaped on output
+			Measure measure("map_json_copy");
+			CountingBuffer buffer;
+			std::ostream out(&buffer);
+			const json::Node node{ map_copy };
+			json::PrintLine(node, out);
+			measure.Report(stops);
+			std::cout << "json_bytes=" << buffer.GetSize() << std::endl;
+		}
+		{
+			//the rendered buffer escaped in place and printed as is
+			Measure measure("map_json_escaped");
+			CountingBuffer buffer;
+			std::ostream out(&buffer);
+			const json::Node node{ json::EscapedString(std::move(map)) };
+			json::PrintLine(node, out);
+			measure.Report(stops);
+			std::cout << "json_bytes=" << buffer.GetSize() << std::endl;
+		}
+	}
+
+	void RunThemesBench(size_t stops) {
+		using namespace std::literals;
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		FillCatalogue(params, tc);
+		std::vector<const Bus*> bus_list = tc.GetBusesVector();
+
+		const RenderSettings base = MakeRenderSettings();
+		renderer::ThemeList themes;
+		RenderSettings dark = base;
+		dark.underlayer_color = svg::Rgb{ 20, 20, 20 };
+		dark.color_palette = { "lime"s, "yellow"s, "cyan"s, "magenta"s };
+		themes.emplace_back("dark"s, dark);
+		RenderSettings print = base;
+		print.line_width = 6;
+		print.stop_radius = 3;
+		print.color_palette = { "black"s };
+		themes.emplace_back("print"s, print);
+		RenderSettings compact = base;
+		compact.shared_styles = true;
+		compact.decimal_places = 1;
+		themes.emplace_back("compact"s, compact);
+
+		size_t separate_bytes = 0;
+		{
+			//every theme builds and projects its own scene
+			Measure measure("themes_separate");
+			const renderer::MapRenderer mr(base);
+			separate_bytes += mr.PrintBusRoutes(bus_list).size();
+			for (const auto& [name, rs] : themes) {
+				const renderer::MapRenderer theme(rs);
+				separate_bytes += theme.PrintBusRoutes(bus_list).size();
+			}
+			measure.Report(stops);
+		}
+		size_t shared_bytes = 0;
+		{
+			Measure measure("themes_shared");
+			const renderer::MapRenderer mr(base, themes);
+			for (const auto& map : mr.RenderThemes(mr.CreateScene(bus_list))) {
+				shared_bytes += map.size();
+			}
+			measure.Report(stops);
+		}
+		std::cout << "themes=" << themes.size() + 1 << " separate_bytes=" << separate_bytes
+			<< " shared_bytes=" << shared_bytes << std::endl;
+	}
+
+	void RunViewportBench(size_t stops) {
+		transportcatalogue::TransportCatalogue tc;
+		CityParams params;
+		params.stops = stops;
+		params.buses = stops / 10;
+		params.route_window = 8;
+		FillCatalogue(params, tc);
+
+		const renderer::MapRenderer mr(MakeRenderSettings());
+		Measure index("viewport_index");
+		renderer::MapScene scene = mr.CreateScene(tc.GetBusesVector());
+		mr.IndexScene(scene);
+		index.Report(stops);
+
+		//square viewports around the city centre, each a quarter of the previous one by area
+		//and drawn one zoom level closer, so the picture size stays the same
+		const geo::Coordinates centre{ 55.7, 37.6 };
+		double half_lat = 0.2;
+		double half_lng = 0.3;
+		for (int zoom = 0; zoom <= 6; ++zoom) {
+			const renderer::Viewport viewport{ { centre.lat - half_lat, centre.lng - half_lng },
+				{ centre.lat + half_lat, centre.lng + half_lng }, zoom };
+			Measure measure("viewport_zoom_" + std::to_string(zoom));
+			std::string map;
+			mr.RenderViewport(scene, viewport, map);
+			measure.Report(stops);
+			std::cout << "map_bytes=" << map.size() << std::endl;
+			half_lat /= 2;
+			half_lng /= 2;
+		}
+	}
+
+}
@@ -0,0 +1,115 @@
+#include <sstream>
+#include <string>
+
+#include "benchmarks.h"
+#include "bench_utils.h"
+
+namespace bench {
+
+	namespace {
+
+		void AddLabel(svg::Document& doc, const RenderSettings& rs, const std::string& name, svg::Point pos) {
+			svg::Text underlayer;
+			underlayer.SetFillColor(rs.underlayer_color).SetStrokeColor(rs.underlayer_color).SetStrokeWidth(rs.underlayer_width);
+			underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+			underlayer.SetPosition(pos).SetOffset(rs.stop_label_offset);
+			underlayer.SetFontSize(rs.stop_label_font_size).SetFontFamily("Verdana").SetFontWeight("bold").SetData(name);
+			doc.Add(std::move(underlayer));
+
+			svg::Text text;
+			text.SetFillColor("black");
+			text.SetPosition(pos).SetOffset(rs.stop_label_offset);
+			text.SetFontSize(rs.stop_label_font_size).SetFontFamily("Verdana").SetFontWeight("bold").SetData(name);
+			doc.Add(std::move(text));
+		}
+
+	}
+
+	namespace {
+
+		//coordinates with a fractional part, as projected stop positions have
+		svg::Point MakePoint(size_t i) {
+			return { static_cast<double>(i % 1200) * 1.0137 + 0.123456, static_cast<double>(i % 977) * 1.2231 + 0.654321 };
+		}
+
+		std::string DecimalsSuffix(int decimals) {
+			return decimals == svg::DEFAULT_DECIMALS ? "" : "_decimals_" + std::to_string(decimals);
+		}
+
+		void RunPolylineBench(size_t points, int decimals) {
+			const size_t points_per_line = 40;
+			svg::Document doc;
+			doc.SetDecimals(decimals);
+			for (size_t i = 0; i < points; i += points_per_line) {
+				svg::Polyline line;
+				line.Reserve(points_per_line);
+				for (size_t j = 0; j != points_per_line; ++j) {
+					line.AddPoint(MakePoint(i + j));
+				}
+				line.SetStrokeColor("green").SetFillColor("none").SetStrokeWidth(14);
+				doc.Add(std::move(line));
+			}
+
+			Measure render("svg_polyline_points" + DecimalsSuffix(decimals));
+			std::string svg;
+			doc.Render(svg);
+			render.Report(points);
+			std::cout << "svg_bytes=" << svg.size() << std::endl;
+		}
+
+		void RunCircleBench(size_t circles, int decimals) {
+			svg::Document doc;
+			doc.SetDecimals(decimals);
+			doc.Reserve(circles);
+			for (size_t i = 0; i != circles; ++i) {
+				doc.Add(svg::Circle{}.SetCenter(MakePoint(i)).SetRadius(5).SetFillColor("white"));
+			}
+
+			Measure render("svg_circles" + DecimalsSuffix(decimals));
+			std::string svg;
+			doc.Render(svg);
+			render.Report(circles);
+			std::cout << "svg_bytes=" << svg.size() << std::endl;
+		}
+
+	}
+
+	void RunSvgBench(size_t elements) {
+		const RenderSettings rs = MakeRenderSettings();
+		const size_t points_per_line = 10;
+		//one polyline, one circle and two labels per step
+		const size_t steps = elements / 4;
+
+		svg::Document doc;
+		Measure build("svg_build");
+		for (size_t i = 0; i != steps; ++i) {
+			const double x = static_cast<double>(i % 1000) * 1.137;
+			const double y = static_cast<double>(i / 1000) * 0.731;
+
+			svg::Polyline line;
+			for (size_t j = 0; j != points_per_line; ++j) {
+				line.AddPoint({ x + j * 3.3, y + j * 1.7 });
+			}
+			line.SetStrokeColor(rs.color_palette[i % rs.color_palette.size()]).SetFillColor("none").SetStrokeWidth(rs.line_width);
+			line.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+			doc.Add(std::move(line));
+
+			doc.Add(svg::Circle{}.SetCenter({ x, y }).SetRadius(rs.stop_radius).SetFillColor("white"));
+			AddLabel(doc, rs, "Stop " + std::to_string(i), { x, y });
+		}
+		build.Report(steps * 4);
+
+		Measure render("svg_render");
+		std::ostringstream out;
+		doc.Render(out);
+		const std::string svg = out.str();
+		render.Report(steps * 4);
+		std::cout << "svg_bytes=" << svg.size() << std::endl;
+
+		for (int decimals : { svg::DEFAULT_DECIMALS, 2 }) {
+			RunPolylineBench(elements * 4, decimals);
+			RunCircleBench(elements, decimals);
+		}
+	}
+
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "catalogue_snapshot.h"
+
+namespace transportcatalogue {
+
+	using namespace snapshot;
+
+	namespace {
+
+		uint64_t Align(uint64_t size) {
+			return (size + 7) & ~uint64_t{ 7 };
+		}
+
+		struct Layout {
+			uint64_t stops;
+			uint64_t buses;
+			uint64_t route_stops;
+			uint64_t distances;
+			uint64_t stop_buses;
+			uint64_t bus_ids;
+			uint64_t names;
+			uint64_t file_size;
+		};
+
+		Layout ComputeLayout(const Header& header) {
+			Layout layout;
+			layout.stops = Align(sizeof(Header));
+			layout.buses = layout.stops + Align(header.stop_count * sizeof(StopRecord));
+			layout.route_stops = layout.buses + Align(header.bus_count * sizeof(BusRecord));
+			layout.distances = layout.route_stops + Align(header.route_stop_count * sizeof(uint32_t));
+			layout.stop_buses = layout.distances + Align(header.distance_count * sizeof(DistanceRecord));
+			layout.bus_ids = layout.stop_buses + Align(header.stop_count * sizeof(IndexRange));
+			layout.names = layout.bus_ids + Align(header.stop_bus_count * sizeof(uint32_t));
+			layout.file_size = layout.names + Align(header.names_size);
+			return layout;
+		}
+
+		//FNV-1a over 8-byte words
+		uint64_t Checksum(const char* data, size_t size) {
+			const uint64_t prime = 1099511628211ull;
+			uint64_t hash = 14695981039346656037ull;
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, data + i, sizeof(word));
+				hash = (hash ^ word) * prime;
+			}
+			for (; i < size; ++i) {
+				hash = (hash ^ static_cast<uint8_t>(data[i])) * prime;
+			}
+			return hash;
+		}
+
+		template <typename T>
+		void AppendSection(std::string& buffer, const std::vector<T>& section) {
+			buffer.append(reinterpret_cast<const char*>(section.data()), section.size() * sizeof(T));
+			buffer.resize(Align(buffer.size()), '\0');
+		}
+
+	}
+
+	// ---------- MappedFile ------------------
+
+	class CatalogueSnapshot::MappedFile {
+	public:
+		explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+			std::ifstream in(path, std::ios::binary | std::ios::ate);
+			if (!in) {
+				throw SnapshotError("can't open snapshot " + path);
+			}
+			size_ = static_cast<size_t>(in.tellg());
+			buffer_.reset(new uint64_t[Align(size_) / sizeof(uint64_t) + 1]);
+			in.seekg(0);
+			in.read(reinterpret_cast<char*>(buffer_.get()), size_);
+			if (!in) {
+				throw SnapshotError("can't read snapshot " + path);
+			}
+			data_ = reinterpret_cast<const char*>(buffer_.get());
+#else
+			const int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw SnapshotError("can't open snapshot " + path);
+			}
+			struct stat st;
+			if (fstat(fd, &st) != 0 || st.st_size == 0) {
+				close(fd);
+				throw SnapshotError("can't read snapshot " + path);
+			}
+			size_ = static_cast<size_t>(st.st_size);
+			void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (addr == MAP_FAILED) {
+				throw SnapshotError("can't map snapshot " + path);
+			}
+			data_ = static_cast<const char*>(addr);
+#endif
+		}
+
+		~MappedFile() {
+#ifndef _WIN32
+			munmap(const_cast<char*>(data_), size_);
+#endif
+		}
+
+		const char* Data() const {
+			return data_;
+		}
+
+		size_t Size() const {
+			return size_;
+		}
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+#ifdef _WIN32
+		std::unique_ptr<uint64_t[]> buffer_;
+#endif
+	};
+
+	// ---------- CatalogueSnapshot ------------------
+
+	CatalogueSnapshot::CatalogueSnapshot(const std::string& path)
+		: file_(std::make_unique<MappedFile>(path))
+	{
+		const char* data = file_->Data();
+		const size_t size = file_->Size();
+		if (size < sizeof(Header)) {
+			throw SnapshotError("snapshot is truncated");
+		}
+
+		header_ = reinterpret_cast<const Header*>(data);
+		if (std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0) {
+			throw SnapshotError("not a catalogue snapshot");
+		}
+		if (header_->endian_mark != ENDIAN_MARK) {
+			throw SnapshotError("snapshot was written on a machine with another byte order");
+		}
+		if (header_->version != VERSION) {
+			throw SnapshotError("unsupported snapshot version " + std::to_string(header_->version));
+		}
+		//every record takes at least 4 bytes, so bigger counts are corrupted
+		for (uint64_t count : { header_->stop_count, header_->bus_count, header_->route_stop_count,
+			header_->distance_count, header_->stop_bus_count, header_->names_size }) {
+			if (count > size) {
+				throw SnapshotError("snapshot is corrupted");
+			}
+		}
+
+		const Layout layout = ComputeLayout(*header_);
+		if (header_->file_size != size || layout.file_size != size) {
+			throw SnapshotError("snapshot size mismatch");
+		}
+		if (Checksum(data + sizeof(Header), size - sizeof(Header)) != header_->checksum) {
+			throw SnapshotError("snapshot checksum mismatch");
+		}
+
+		stops_ = reinterpret_cast<const StopRecord*>(data + layout.stops);
+		buses_ = reinterpret_cast<const BusRecord*>(data + layout.buses);
+		route_stops_ = reinterpret_cast<const uint32_t*>(data + layout.route_stops);
+		distances_ = reinterpret_cast<const DistanceRecord*>(data + layout.distances);
+		stop_buses_ = reinterpret_cast<const IndexRange*>(data + layout.stop_buses);
+		bus_ids_ = reinterpret_cast<const uint32_t*>(data + layout.bus_ids);
+		names_ = data + layout.names;
+
+		Validate();
+	}
+
+	CatalogueSnapshot::~CatalogueSnapshot() = default;
+
+	void CatalogueSnapshot::Validate() const {
+		auto check = [](bool condition) {
+			if (!condition) {
+				throw SnapshotError("snapshot is corrupted");
+			}
+		};
+		auto check_name = [this, &check](uint64_t offset, uint64_t size) {
+			check(offset <= header_->names_size && size <= header_->names_size - offset);
+		};
+
+		for (size_t i = 0; i != header_->stop_count; ++i) {
+			check_name(stops_[i].name_offset, stops_[i].name_size);
+			const IndexRange& range = stop_buses_[i];
+			check(range.offset <= header_->stop_bus_count && range.count <= header_->stop_bus_count - range.offset);
+		}
+		for (size_t i = 0; i != header_->bus_count; ++i) {
+			const BusRecord& bus = buses_[i];
+			check_name(bus.name_offset, bus.name_size);
+			check(bus.stops_offset <= header_->route_stop_count && bus.stops_count <= header_->route_stop_count - bus.stops_offset);
+		}
+		for (size_t i = 0; i != header_->route_stop_count; ++i) {
+			check(route_stops_[i] < header_->stop_count);
+		}
+		for (size_t i = 0; i != header_->distance_count; ++i) {
+			check(distances_[i].from < header_->stop_count && distances_[i].to < header_->stop_count);
+		}
+		for (size_t i = 0; i != header_->stop_bus_count; ++i) {
+			check(bus_ids_[i] < header_->bus_count);
+		}
+	}
+
+	std::string_view CatalogueSnapshot::GetName(uint64_t offset, uint64_t size) const {
+		return { names_ + offset, static_cast<size_t>(size) };
+	}
+
+	size_t CatalogueSnapshot::GetStopCount() const {
+		return static_cast<size_t>(header_->stop_count);
+	}
+
+	std::string_view CatalogueSnapshot::GetStopName(size_t stop) const {
+		return GetName(stops_[stop].name_offset, stops_[stop].name_size);
+	}
+
+	geo::Coordinates CatalogueSnapshot::GetStopCoordinates(size_t stop) const {
+		return { stops_[stop].lat, stops_[stop].lng };
+	}
+
+	ranges::Range<const uint32_t*> CatalogueSnapshot::GetStopBuses(size_t stop) const {
+		const IndexRange& range = stop_buses_[stop];
+		return { bus_ids_ + range.offset, bus_ids_ + range.offset + range.count };
+	}
+
+	size_t CatalogueSnapshot::GetBusCount() const {
+		return static_cast<size_t>(header_->bus_count);
+	}
+
+	std::string_view CatalogueSnapshot::GetBusName(size_t bus) const {
+		return GetName(buses_[bus].name_offset, buses_[bus].name_size);
+	}
+
+	bool CatalogueSnapshot::IsRoundtrip(size_t bus) const {
+		return buses_[bus].is_roundtrip != 0;
+	}
+
+	ranges::Range<const uint32_t*> CatalogueSnapshot::GetBusStops(size_t bus) const {
+		const BusRecord& record = buses_[bus];
+		return { route_stops_ + record.stops_offset, route_stops_ + record.stops_offset + record.stops_count };
+	}
+
+	ranges::Range<const DistanceRecord*> CatalogueSnapshot::GetDistances() const {
+		return { distances_, distances_ + header_->distance_count };
+	}
+
+	// ---------- Save / Load ------------------
+
+	void SaveSnapshot(const TransportCatalogue& tc, std::ostream& out) {
+		const auto& stops = tc.GetStops();
+		const auto& buses = tc.GetBuses();
+		std::string names;
+
+		std::vector<StopRecord> stop_records;
+		stop_records.reserve(stops.size());
+		for (const Stop& stop : stops) {
+			stop_records.push_back({ names.size(), stop.name.size(), stop.coordiante.lat, stop.coordiante.lng });
+			names += stop.name;
+		}
+
+		std::vector<BusRecord> bus_records;
+		std::vector<uint32_t> route_stops;
+		std::vector<std::vector<uint32_t>> buses_by_stop(stops.size());
+		bus_records.reserve(buses.size());
+		for (const Bus& bus : buses) {
+			bus_records.push_back({ names.size(), bus.name.size(), route_stops.size(),
+				static_cast<uint32_t>(bus.stops.size()), bus.is_roundtrip ? 1u : 0u });
+			names += bus.name;
+			for (const Stop* stop : bus.stops) {
+				route_stops.push_back(static_cast<uint32_t>(stop->id));
+			}
+			for (const Stop* stop : bus.uniq_stops) {
+				buses_by_stop[stop->id].push_back(static_cast<uint32_t>(bus.id));
+			}
+		}
+
+		std::vector<DistanceRecord> distances;
+		distances.reserve(tc.GetDistances().size());
+		for (const auto& [stops_pair, distance] : tc.GetDistances()) {
+			distances.push_back({ static_cast<uint32_t>(tc.GetStop(stops_pair.first)->id),
+				static_cast<uint32_t>(tc.GetStop(stops_pair.second)->id), distance });
+		}
+		std::sort(distances.begin(), distances.end(), [](const auto& l, const auto& r) {
+			return std::make_pair(l.from, l.to) < std::make_pair(r.from, r.to); });
+
+		std::vector<IndexRange> stop_buses;
+		std::vector<uint32_t> bus_ids;
+		stop_buses.reserve(stops.size());
+		for (auto& ids : buses_by_stop) {
+			std::sort(ids.begin(), ids.end(), [&buses](uint32_t l, uint32_t r) {
+				return buses[l].name < buses[r].name; });
+			stop_buses.push_back({ bus_ids.size(), ids.size() });
+			bus_ids.insert(bus_ids.end(), ids.begin(), ids.end());
+		}
+
+		Header header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.endian_mark = ENDIAN_MARK;
+		header.stop_count = stop_records.size();
+		header.bus_count = bus_records.size();
+		header.route_stop_count = route_stops.size();
+		header.distance_count = distances.size();
+		header.stop_bus_count = bus_ids.size();
+		header.names_size = names.size();
+
+		const Layout layout = ComputeLayout(header);
+		std::string buffer;
+		buffer.reserve(layout.file_size);
+		buffer.resize(layout.stops, '\0');
+		AppendSection(buffer, stop_records);
+		AppendSection(buffer, bus_records);
+		AppendSection(buffer, route_stops);
+		AppendSection(buffer, distances);
+		AppendSection(buffer, stop_buses);
+		AppendSection(buffer, bus_ids);
+		buffer += names;
+		buffer.resize(Align(buffer.size()), '\0');
+
+		header.file_size = buffer.size();
+		header.checksum = Checksum(buffer.data() + sizeof(Header), buffer.size() - sizeof(Header));
+		std::memcpy(buffer.data(), &header, sizeof(Header));
+
+		out.write(buffer.data(), buffer.size());
+		if (!out) {
+			throw SnapshotError("can't write snapshot");
+		}
+	}
+
+	TransportCatalogue LoadSnapshot(const CatalogueSnapshot& snapshot) {
+		TransportCatalogue tc;
+		const size_t stop_count = snapshot.GetStopCount();
+		const size_t bus_count = snapshot.GetBusCount();
+		tc.stopname_to_stop_.reserve(stop_count);
+		tc.stops_to_bus_.reserve(stop_count);
+		tc.busname_to_bus_.reserve(bus_count);
+		const auto distances = snapshot.GetDistances();
+		tc.distance_between_stops_.reserve(distances.end() - distances.begin());
+
+		for (size_t i = 0; i != stop_count; ++i) {
+			Stop& stop = tc.stops_.emplace_back();
+			stop.name = snapshot.GetStopName(i);
+			stop.coordiante = snapshot.GetStopCoordinates(i);
+			stop.id = i;
+			tc.stopname_to_stop_.emplace(stop.name, &stop);
+		}
+
+		//the unique stops of a bus are the stops that list it in the index
+		std::vector<size_t> uniq_counts(bus_count, 0);
+		for (size_t i = 0; i != stop_count; ++i) {
+			for (uint32_t bus : snapshot.GetStopBuses(i)) {
+				++uniq_counts[bus];
+			}
+		}
+		for (size_t i = 0; i != bus_count; ++i) {
+			Bus& bus = tc.buses_.emplace_back();
+			bus.name = snapshot.GetBusName(i);
+			bus.is_roundtrip = snapshot.IsRoundtrip(i);
+			bus.id = i;
+			const auto route = snapshot.GetBusStops(i);
+			bus.stops.reserve(route.end() - route.begin());
+			for (uint32_t stop : route) {
+				bus.stops.push_back(&tc.stops_[stop]);
+			}
+			bus.uniq_stops.reserve(uniq_counts[i]);
+			tc.busname_to_bus_.emplace(bus.name, &bus);
+		}
+
+		for (size_t i = 0; i != stop_count; ++i) {
+			const Stop& stop = tc.stops_[i];
+			const auto buses = snapshot.GetStopBuses(i);
+			auto& names = tc.stops_to_bus_[stop.name];
+			names.reserve(buses.end() - buses.begin());
+			for (uint32_t bus : buses) {
+				names.insert(tc.buses_[bus].name);
+				tc.buses_[bus].uniq_stops.insert(&stop);
+			}
+		}
+
+		for (const DistanceRecord& distance : distances) {
+			tc.distance_between_stops_.emplace(std::make_pair(std::string_view(tc.stops_[distance.from].name),
+				std::string_view(tc.stops_[distance.to].name)), distance.distance);
+		}
+		return tc;
+	}
+
+}
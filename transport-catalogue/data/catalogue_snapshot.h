@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "ranges.h"
+#include "transport_catalogue.h"
+
+namespace transportcatalogue {
+
+	// Binary snapshot of a built catalogue. All integers are stored in the byte order
+	// of the machine that wrote the file, every section is aligned to 8 bytes:
+	// Header | StopRecord[] | BusRecord[] | uint32 route stops | DistanceRecord[] |
+	// IndexRange[] (buses of each stop) | uint32 bus ids | names
+	namespace snapshot {
+
+		inline constexpr char MAGIC[8] = { 'T', 'C', 'S', 'N', 'A', 'P', '\0', '\0' };
+		inline constexpr uint32_t VERSION = 1;
+		inline constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+		struct Header {
+			char magic[8];
+			uint32_t version;
+			uint32_t endian_mark;
+			uint64_t file_size;
+			//checksum of everything after the header
+			uint64_t checksum;
+			uint64_t stop_count;
+			uint64_t bus_count;
+			uint64_t route_stop_count;
+			uint64_t distance_count;
+			uint64_t stop_bus_count;
+			uint64_t names_size;
+		};
+
+		struct StopRecord {
+			uint64_t name_offset;
+			uint64_t name_size;
+			double lat;
+			double lng;
+		};
+
+		struct BusRecord {
+			uint64_t name_offset;
+			uint64_t name_size;
+			uint64_t stops_offset;
+			uint32_t stops_count;
+			uint32_t is_roundtrip;
+		};
+
+		struct DistanceRecord {
+			uint32_t from;
+			uint32_t to;
+			int32_t distance;
+		};
+
+		//slice of the bus id section, buses are sorted by name
+		struct IndexRange {
+			uint64_t offset;
+			uint64_t count;
+		};
+
+	}
+
+	class SnapshotError : public std::runtime_error {
+	public:
+		using runtime_error::runtime_error;
+	};
+
+	// Read-only view of a snapshot file mapped into memory. The getters read names and
+	// arrays in place; opening the view costs only the checksum pass
+	class CatalogueSnapshot {
+	public:
+		explicit CatalogueSnapshot(const std::string& path);
+		~CatalogueSnapshot();
+
+		CatalogueSnapshot(const CatalogueSnapshot&) = delete;
+		CatalogueSnapshot& operator=(const CatalogueSnapshot&) = delete;
+
+		size_t GetStopCount() const;
+		std::string_view GetStopName(size_t stop) const;
+		geo::Coordinates GetStopCoordinates(size_t stop) const;
+		ranges::Range<const uint32_t*> GetStopBuses(size_t stop) const;
+
+		size_t GetBusCount() const;
+		std::string_view GetBusName(size_t bus) const;
+		bool IsRoundtrip(size_t bus) const;
+		ranges::Range<const uint32_t*> GetBusStops(size_t bus) const;
+
+		ranges::Range<const snapshot::DistanceRecord*> GetDistances() const;
+
+	private:
+		class MappedFile;
+		std::unique_ptr<MappedFile> file_;
+
+		const snapshot::Header* header_ = nullptr;
+		const snapshot::StopRecord* stops_ = nullptr;
+		const snapshot::BusRecord* buses_ = nullptr;
+		const uint32_t* route_stops_ = nullptr;
+		const snapshot::DistanceRecord* distances_ = nullptr;
+		const snapshot::IndexRange* stop_buses_ = nullptr;
+		const uint32_t* bus_ids_ = nullptr;
+		const char* names_ = nullptr;
+
+		void Validate() const;
+		std::string_view GetName(uint64_t offset, uint64_t size) const;
+	};
+
+	void SaveSnapshot(const TransportCatalogue& tc, std::ostream& out);
+
+	//builds the catalogue from a snapshot, stops and buses are resolved by id instead of by name.
+	//It is a copying loader: the catalogue owns its names and rebuilds its hash indexes, so
+	//the time is linear in the size of the network, only the JSON parsing is saved
+	TransportCatalogue LoadSnapshot(const CatalogueSnapshot& snapshot);
+
+}
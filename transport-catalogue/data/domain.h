@@ -12,11 +12,15 @@ struct Stop;
 struct Stop {
 	std::string name;
 	geo::Coordinates coordiante;
+	//position in the catalogue, stops are numbered from 0 in order of addition
+	size_t id = 0;
 };
 
 struct Bus{
 	std::string name;
 	bool is_roundtrip;
+	//position in the catalogue, buses are numbered from 0 in order of addition
+	size_t id = 0;
 	std::vector<const Stop*> stops;
 	std::unordered_set<const Stop*> uniq_stops;
 };
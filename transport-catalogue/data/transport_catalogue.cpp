@@ -4,11 +4,12 @@
 
 namespace transportcatalogue {
 
-	void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coordinates) {
+	void TransportCatalogue::AddStop(std::string name, geo::Coordinates coordinates) {
 		Stop stop;
-		stop.name = name;
+		stop.name = std::move(name);
 		stop.coordiante = coordinates;
-		stops_.push_back(stop);
+		stop.id = stops_.size();
+		stops_.push_back(std::move(stop));
 		std::string_view sv_name = stops_.back().name;
 		stopname_to_stop_[sv_name] = &stops_.back();
 		stops_to_bus_[sv_name];
@@ -19,27 +20,33 @@ namespace transportcatalogue {
 			if (dist.name_stop1 == "" || dist.name_stop2 == "" || dist.distance == 0) {
 				return;
 			}
-			std::string_view stop1 = stopname_to_stop_.at(dist.name_stop1)->name;
-			std::string_view stop2 = stopname_to_stop_.at(dist.name_stop2)->name;
-			std::pair<std::string_view, std::string_view> pair_stops = std::make_pair(stop1, stop2);
-
-			distance_between_stops_[pair_stops] = dist.distance;
+			SetDistance(stopname_to_stop_.at(dist.name_stop1), stopname_to_stop_.at(dist.name_stop2), dist.distance);
 		}
 	}
 
+	void TransportCatalogue::SetDistance(const Stop* stop1, const Stop* stop2, int distance) {
+		std::pair<std::string_view, std::string_view> pair_stops{ stop1->name, stop2->name };
+		distance_between_stops_[pair_stops] = distance;
+	}
+
 	void TransportCatalogue::AddBus(const std::string& name, bool is_roundtrip, const std::vector<std::string_view>& stops) {
+		std::vector<const Stop*> route;
+		route.reserve(stops.size());
+		for (auto& stop : stops) {
+			route.emplace_back(stopname_to_stop_.at(stop));
+		}
+		AddBus(name, is_roundtrip, route);
+	}
+
+	void TransportCatalogue::AddBus(const std::string& name, bool is_roundtrip, const std::vector<const Stop*>& stops) {
 		Bus bus;
 		bus.name = name;
-		bus.stops.reserve(stops.size());
 		bus.is_roundtrip = is_roundtrip;
+		bus.id = buses_.size();
+		bus.stops = stops;
+		bus.uniq_stops.insert(stops.begin(), stops.end());
 
-		for (auto& stop : stops) {
-			auto st = stopname_to_stop_.at(stop);
-			bus.stops.emplace_back(st);
-			bus.uniq_stops.emplace(st);
-		}
-
-		buses_.push_back(bus);
+		buses_.push_back(std::move(bus));
 		std::string_view sv_name = buses_.back().name;
 		busname_to_bus_[sv_name] = &buses_.back();
 		
@@ -127,5 +134,40 @@ namespace transportcatalogue {
 		return buses_;
 	}
 
+	const Stop* TransportCatalogue::GetStop(std::string_view stop) const {
+		auto it = stopname_to_stop_.find(stop);
+		return it == stopname_to_stop_.end() ? nullptr : it->second;
+	}
+
+	const Bus* TransportCatalogue::GetBus(std::string_view bus_number) const {
+		auto it = busname_to_bus_.find(bus_number);
+		return it == busname_to_bus_.end() ? nullptr : it->second;
+	}
+
+	const TransportCatalogue::DistanceMap& TransportCatalogue::GetDistances() const {
+		return distance_between_stops_;
+	}
+
+	util::MemoryUsage TransportCatalogue::GetMemoryUsage() const {
+		util::MemoryUsage usage;
+		usage.AddDeque(stops_);
+		for (const Stop& stop : stops_) {
+			usage.AddString(stop.name);
+		}
+		usage.AddDeque(buses_);
+		for (const Bus& bus : buses_) {
+			usage.AddString(bus.name);
+			usage.AddVector(bus.stops);
+			usage.AddHashTable(bus.uniq_stops);
+		}
+		usage.AddHashTable(stopname_to_stop_);
+		usage.AddHashTable(busname_to_bus_);
+		usage.AddHashTable(stops_to_bus_);
+		for (const auto& [stop, buses] : stops_to_bus_) {
+			usage.AddHashTable(buses);
+		}
+		usage.AddHashTable(distance_between_stops_);
+		return usage;
+	}
 
 }
\ No newline at end of file
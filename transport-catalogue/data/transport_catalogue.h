@@ -6,6 +6,7 @@
 #include <unordered_map>
 
 #include "domain.h"
+#include "../util/memory_usage.h"
 
 namespace transportcatalogue {
 
@@ -28,12 +29,21 @@ namespace transportcatalogue {
 		}
 	};
 
+	class CatalogueSnapshot;
+	class TransportCatalogue;
+
+	TransportCatalogue LoadSnapshot(const CatalogueSnapshot& snapshot);
+
 	class TransportCatalogue {
 	public:
+		using DistanceMap = std::unordered_map<std::pair<std::string_view, std::string_view>, int, DBSHasher>;
+
 		//add Transport Catalogue information
-		void AddStop(const std::string& name, geo::Coordinates coordinates);
+		void AddStop(std::string name, geo::Coordinates coordinates);
 		void FillDistanceList(const std::vector<DistanceBetStops>& vector_dist);
+		void SetDistance(const Stop* stop1, const Stop* stop2, int distance);
 		void AddBus(const std::string& name, bool is_roundtrip, const std::vector<std::string_view>& stops);
+		void AddBus(const std::string& name, bool is_roundtrip, const std::vector<const Stop*>& stops);
 
 		//get Transport Catalogue information
 		int GetBusStopsCount(std::string_view bus_number) const ;
@@ -49,8 +59,16 @@ namespace transportcatalogue {
 		//
 		const std::deque<Bus>& GetBuses() const;
 		const std::deque<Stop>& GetStops() const;
+		const Stop* GetStop(std::string_view stop) const;
+		const Bus* GetBus(std::string_view bus_number) const;
+		const DistanceMap& GetDistances() const;
+		//heap memory of the stops, the buses and the indexes over them
+		util::MemoryUsage GetMemoryUsage() const;
 
 	private:
+		//fills the containers directly, the snapshot already has the stop -> buses index
+		friend TransportCatalogue LoadSnapshot(const CatalogueSnapshot& snapshot);
+
 		//base information
 		std::deque<Stop> stops_;
 		std::deque<Bus> buses_;
@@ -59,7 +77,7 @@ namespace transportcatalogue {
 		std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
 		std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
 		std::unordered_map<std::string_view, std::unordered_set<std::string_view>> stops_to_bus_;
-		std::unordered_map<std::pair<std::string_view, std::string_view>, int, DBSHasher> distance_between_stops_;
+		DistanceMap distance_between_stops_;
 
 		double MinDistanceBusRoute(std::string_view bus_number) const;
 	};
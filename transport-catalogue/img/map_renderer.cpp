@@ -1,80 +1,404 @@
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
 #include "map_renderer.h"
+#include "simplify.h"
+#include "../util/thread_pool.h"
 
 namespace renderer {
 
-    std::ostringstream MapRenderer::PrintBusRoutes(std::vector<const Bus*>& bus_list) const {
+    MapRenderer::MapRenderer(const RenderSettings& rs, const ThemeList& themes)
+        : rs_(rs) {
+        if (rs_.shared_styles) {
+            CreateStyleSheet();
+        }
+        themes_.reserve(themes.size());
+        for (const auto& [name, theme] : themes) {
+            if (theme.width != rs_.width || theme.height != rs_.height || theme.padding != rs_.padding) {
+                throw std::invalid_argument("theme '" + name + "' changes the canvas of the map");
+            }
+            themes_.emplace_back(name, std::make_unique<MapRenderer>(theme));
+        }
+    }
+
+    size_t MapRenderer::GetThemeCount() const {
+        return themes_.size() + 1;
+    }
+
+    std::optional<size_t> MapRenderer::FindTheme(std::string_view name) const {
+        if (name.empty()) {
+            return 0;
+        }
+        for (size_t i = 0; i != themes_.size(); ++i) {
+            if (themes_[i].first == name) {
+                return i + 1;
+            }
+        }
+        return std::nullopt;
+    }
+
+    const MapRenderer& MapRenderer::GetTheme(size_t index) const {
+        return index == 0 ? *this : *themes_.at(index - 1).second;
+    }
+
+    std::vector<std::string> MapRenderer::RenderThemes(const MapScene& scene) const {
+        std::vector<std::string> maps(GetThemeCount());
+        for (size_t i = 0; i != maps.size(); ++i) {
+            GetTheme(i).RenderScene(scene, maps[i]);
+        }
+        return maps;
+    }
+
+    void MapRenderer::CreateStyleSheet() {
+        using namespace std::literals;
+        //numbers are rounded like the attributes of the elements
+        style_sheet_.clear();
+        svg::Writer css(style_sheet_, rs_.decimal_places);
+        css << ".l{fill:none;stroke-width:"sv << rs_.line_width << ";stroke-linecap:round;stroke-linejoin:round}"sv;
+        css << ".u{fill:"sv << rs_.underlayer_color << ";stroke:"sv << rs_.underlayer_color
+            << ";stroke-width:"sv << rs_.underlayer_width << ";stroke-linecap:round;stroke-linejoin:round}"sv;
+        css << ".b{font-size:"sv << rs_.bus_label_font_size << "px;font-family:"sv << font_family_.View()
+            << ";font-weight:"sv << font_weight_.View() << "}"sv;
+        css << ".n{font-size:"sv << rs_.stop_label_font_size << "px;font-family:"sv << font_family_.View() << "}"sv;
+        css << ".k{fill:black}.s{fill:white}"sv;
+
+        const size_t colors = std::max<size_t>(rs_.color_palette.size(), 1);
+        for (size_t i = 0; i != colors; ++i) {
+            const uint32_t index = static_cast<uint32_t>(i);
+            css << ".p"sv << index << "{stroke:"sv << GetPaletteColor(i) << "}.t"sv << index << "{fill:"sv << GetPaletteColor(i) << "}"sv;
+            line_classes_.emplace_back("l p" + std::to_string(i));
+            bus_label_classes_.emplace_back("b t" + std::to_string(i));
+        }
+    }
+
+    void MapRenderer::AddStyleSheet(svg::Document& routemap) const {
+        if (rs_.shared_styles) {
+            routemap.Add(svg::Style(style_sheet_));
+        }
+    }
+
+    std::string MapRenderer::PrintBusRoutes(std::vector<const Bus*>& bus_list) const {
+        std::string map;
+        RenderScene(CreateScene(bus_list), map);
+        return map;
+    }
+
+    MapScene MapRenderer::CreateScene(std::vector<const Bus*> bus_list) const {
+        MapScene scene;
+        bus_list.erase(std::remove_if(bus_list.begin(), bus_list.end(), [](const Bus* bus) {
+            return bus->stops.empty(); }), bus_list.end());
         std::sort(bus_list.begin(), bus_list.end(), [](const auto& l, const auto& r) {
             return l->name < r->name; });
+        scene.buses = std::move(bus_list);
+
+        //collect unique stops by id
+        const uint32_t no_stop = std::numeric_limits<uint32_t>::max();
+        size_t max_id = 0;
+        for (const auto& bus : scene.buses) {
+            for (const auto& stop : bus->stops) {
+                max_id = std::max(max_id, stop->id);
+            }
+        }
+        scene.stop_index.assign(scene.buses.empty() ? 0 : max_id + 1, no_stop);
+        for (const auto& bus : scene.buses) {
+            for (const auto& stop : bus->stops) {
+                if (scene.stop_index[stop->id] == no_stop) {
+                    scene.stop_index[stop->id] = static_cast<uint32_t>(scene.stops.size());
+                    scene.stops.emplace_back(stop);
+                }
+            }
+        }
 
-        svg::Document routemap;
-        size_t palette_number = 0;
         std::vector<geo::Coordinates> all_stops_coord;
-        std::vector<const Stop*> all_stops;
+        all_stops_coord.reserve(scene.stops.size());
+        for (const auto& stop : scene.stops) {
+            all_stops_coord.emplace_back(stop->coordiante);
+        }
+        scene.projector = CreateProjector(all_stops_coord);
+
+        std::sort(scene.stops.begin(), scene.stops.end(), [](const auto& l, const auto& r) {
+            return l->name < r->name; });
 
-        for (const auto& bus : bus_list) {
-            all_stops_coord.reserve(all_stops_coord.size() + bus->stops.size());
+        scene.stop_points.reserve(scene.stops.size());
+        for (size_t i = 0; i != scene.stops.size(); ++i) {
+            scene.stop_index[scene.stops[i]->id] = static_cast<uint32_t>(i);
+            scene.stop_points.emplace_back(scene.projector(scene.stops[i]->coordiante));
+        }
+        return scene;
+    }
+
+    namespace {
+
+        enum class Layer {
+            RouteLines,
+            BusLabels,
+            StopCircles,
+            StopLabels
+        };
+
+        struct LayerChunk {
+            Layer layer;
+            size_t begin;
+            size_t end;
+        };
+
+        const size_t BUS_CHUNK_SIZE = 256;
+        const size_t STOP_CHUNK_SIZE = 2048;
+        //maps with fewer buses and stops are rendered on the calling thread
+        const size_t PARALLEL_RENDER_THRESHOLD = 4096;
+
+        void SplitLayer(std::vector<LayerChunk>& chunks, Layer layer, size_t size, size_t chunk_size) {
+            for (size_t begin = 0; begin < size; begin += chunk_size) {
+                chunks.push_back({ layer, begin, std::min(size, begin + chunk_size) });
+            }
+        }
+
+    }
+
+    void MapRenderer::RenderScene(const MapScene& scene, std::string& buffer) const {
+        if (scene.buses.size() + scene.stops.size() < PARALLEL_RENDER_THRESHOLD) {
+            svg::Document routemap;
+            routemap.SetDecimals(rs_.decimal_places);
+            routemap.Reserve(scene.buses.size() * 5 + scene.stops.size() * 3 + 1);
+            AddStyleSheet(routemap);
+            AddRouteLines(routemap, scene, 0, scene.buses.size());
+            AddBusLabels(routemap, scene, 0, scene.buses.size());
+            AddStopCircles(routemap, scene, 0, scene.stops.size());
+            AddStopLabels(routemap, scene, 0, scene.stops.size());
+            routemap.Render(buffer);
+            return;
+        }
+
+        //layers don't depend on each other, every chunk of a layer is serialized
+        //into its own buffer and the buffers are joined in the drawing order
+        std::vector<LayerChunk> chunks;
+        SplitLayer(chunks, Layer::RouteLines, scene.buses.size(), BUS_CHUNK_SIZE);
+        SplitLayer(chunks, Layer::BusLabels, scene.buses.size(), BUS_CHUNK_SIZE);
+        SplitLayer(chunks, Layer::StopCircles, scene.stops.size(), STOP_CHUNK_SIZE);
+        SplitLayer(chunks, Layer::StopLabels, scene.stops.size(), STOP_CHUNK_SIZE);
+
+        std::vector<std::string> buffers(chunks.size());
+        util::GetSharedPool().ParallelFor(chunks.size(), [&](size_t i) {
+            const LayerChunk& chunk = chunks[i];
+            svg::Document layer;
+            layer.SetDecimals(rs_.decimal_places);
+            switch (chunk.layer) {
+            case Layer::RouteLines:
+                AddRouteLines(layer, scene, chunk.begin, chunk.end);
+                break;
+            case Layer::BusLabels:
+                AddBusLabels(layer, scene, chunk.begin, chunk.end);
+                break;
+            case Layer::StopCircles:
+                AddStopCircles(layer, scene, chunk.begin, chunk.end);
+                break;
+            case Layer::StopLabels:
+                AddStopLabels(layer, scene, chunk.begin, chunk.end);
+                break;
+            }
+            layer.RenderObjects(buffers[i]);
+        });
+
+        svg::Document::RenderHeader(buffer);
+        svg::Document style;
+        AddStyleSheet(style);
+        style.RenderObjects(buffer);
+        size_t size = buffer.size();
+        for (const auto& chunk : buffers) {
+            size += chunk.size();
+        }
+        //the headroom lets a caller escape the map in place without another reallocation
+        buffer.reserve(size + size / 8);
+        for (const auto& chunk : buffers) {
+            buffer += chunk;
+        }
+        svg::Document::RenderFooter(buffer);
+    }
+
+    void MapRenderer::AddRouteLines(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const {
+        std::vector<svg::Point> points;
+        for (size_t i = begin; i != end; ++i) {
+            const Bus* bus = scene.buses[i];
+            points.clear();
             for (const auto& stop : bus->stops) {
-                if(std::find(all_stops.begin(), all_stops.end(), stop) == all_stops.end()){
-                    all_stops.emplace_back(stop);
-                    all_stops_coord.emplace_back(stop->coordiante);
-                }
-            }           
+                points.emplace_back(scene.GetPoint(stop));
+            }
+            AddRouteLine(routemap, i, points);
         }
+    }
 
-        const SphereProjector proj = CreateProjector(all_stops_coord);
+    void MapRenderer::AddBusLabels(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const {
+        for (size_t i = begin; i != end; ++i) {
+            const Bus* bus = scene.buses[i];
+            const svg::Point screen_coord = scene.GetPoint(bus->stops[0]);
+            routemap.Add(CreateRouteBusNameMain(bus->name, screen_coord));
+            routemap.Add(CreateRouteBusNameAdd(bus->name, screen_coord, i));
 
-        //print route line
-        for (const auto& bus : bus_list) {
-            svg::Polyline route;
-            if(!bus->stops.empty()){
-                for (const auto& stop : bus->stops) {
-                    const svg::Point screen_coord = proj(stop->coordiante);
-                    route.AddPoint({ screen_coord.x, screen_coord.y });
-                }
-                route.SetStrokeColor(rs_.color_palette[palette_number]).SetFillColor("none").SetStrokeWidth(rs_.line_width);
-                route.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-                routemap.Add(route);
+            if (!bus->is_roundtrip && bus->stops[0] != bus->stops[bus->stops.size() / 2]) {
+                const svg::Point screen_coord2 = scene.GetPoint(bus->stops[bus->stops.size() / 2]);
+                routemap.Add(CreateRouteBusNameMain(bus->name, screen_coord2));
+                routemap.Add(CreateRouteBusNameAdd(bus->name, screen_coord2, i));
+            }
+        }
+    }
+
+    void MapRenderer::AddStopCircles(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const {
+        for (size_t i = begin; i != end; ++i) {
+            routemap.Add(CreateStopCircle(scene.stop_points[i]));
+        }
+    }
 
-                palette_number = GetNextColorPalette(palette_number);
+    void MapRenderer::AddStopLabels(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const {
+        for (size_t i = begin; i != end; ++i) {
+            routemap.Add(CreateRouteStopNameMain(scene.stops[i]->name, scene.stop_points[i]));
+            routemap.Add(CreateRouteStopNameAdd(scene.stops[i]->name, scene.stop_points[i]));
+        }
+    }
+
+    namespace {
+
+        //maps the part of the whole-network picture under a viewport to the viewport picture
+        struct ViewTransform {
+            svg::Point origin;
+            double scale = 1;
+
+            svg::Point operator()(svg::Point p) const {
+                return { (p.x - origin.x) * scale, (p.y - origin.y) * scale };
             }
+        };
+
+        //how far lines, circles and labels reach past their anchor point, in screen units.
+        //long labels may still be cut at the viewport border
+        double GetDrawingMargin(const RenderSettings& rs) {
+            const double offset = std::max({ std::abs(rs.bus_label_offset.x), std::abs(rs.bus_label_offset.y),
+                std::abs(rs.stop_label_offset.x), std::abs(rs.stop_label_offset.y) });
+            const double font_size = std::max(rs.bus_label_font_size, rs.stop_label_font_size);
+            return std::max(rs.stop_radius, rs.line_width / 2) + offset + font_size + rs.underlayer_width;
         }
 
-        //print route name
-        palette_number = 0;
-        for (const auto& bus : bus_list) {
-            if (!bus->stops.empty()) {
-                const svg::Point screen_coord = proj(bus->stops[0]->coordiante);
-                routemap.Add(CreateRouteBusNameMain(bus->name, screen_coord));
-                routemap.Add(CreateRouteBusNameAdd(bus->name, screen_coord, palette_number));
+    }
 
-                if (!bus->is_roundtrip && bus->stops[0] != bus->stops[bus->stops.size() / 2]) {
-                    const svg::Point screen_coord2 = proj(bus->stops[bus->stops.size()/2]->coordiante);
-                    routemap.Add(CreateRouteBusNameMain(bus->name, screen_coord2));
-                    routemap.Add(CreateRouteBusNameAdd(bus->name, screen_coord2, palette_number));
-                }
-                palette_number = GetNextColorPalette(palette_number);
+    void MapRenderer::IndexScene(MapScene& scene) const {
+        if (scene.stop_points.empty()) {
+            return;
+        }
+        Box bounds = Box::Of(scene.stop_points[0], scene.stop_points[0]);
+        for (const svg::Point& p : scene.stop_points) {
+            bounds.min_x = std::min(bounds.min_x, p.x);
+            bounds.min_y = std::min(bounds.min_y, p.y);
+            bounds.max_x = std::max(bounds.max_x, p.x);
+            bounds.max_y = std::max(bounds.max_y, p.y);
+        }
+
+        //about four stops per cell
+        const double area = std::max(bounds.max_x - bounds.min_x, 1.0) * std::max(bounds.max_y - bounds.min_y, 1.0);
+        scene.stop_grid = SpatialGrid(bounds, std::sqrt(area * 4 / static_cast<double>(scene.stops.size())));
+        for (size_t i = 0; i != scene.stops.size(); ++i) {
+            scene.stop_grid.Insert(static_cast<uint32_t>(i), scene.stop_points[i]);
+        }
+
+        //cells are no smaller than an average segment, so a segment crosses a few cells
+        //and the index stays proportional to the number of segments
+        size_t segment_count = 0;
+        double total_length = 0;
+        for (const Bus* bus : scene.buses) {
+            for (size_t j = 1; j < bus->stops.size(); ++j) {
+                const svg::Point from = scene.GetPoint(bus->stops[j - 1]);
+                const svg::Point to = scene.GetPoint(bus->stops[j]);
+                total_length += std::hypot(to.x - from.x, to.y - from.y);
+                ++segment_count;
+            }
+        }
+        const double segment_cell = segment_count ? total_length / static_cast<double>(segment_count) : 0;
+        const double area_cell = std::sqrt(area * 4 / static_cast<double>(std::max<size_t>(segment_count, 1)));
+        scene.bus_grid = SpatialGrid(bounds, std::max(segment_cell, area_cell));
+        for (size_t i = 0; i != scene.buses.size(); ++i) {
+            const auto& stops = scene.buses[i]->stops;
+            svg::Point prev = scene.GetPoint(stops[0]);
+            scene.bus_grid.Insert(static_cast<uint32_t>(i), prev);
+            for (size_t j = 1; j < stops.size(); ++j) {
+                const svg::Point next = scene.GetPoint(stops[j]);
+                scene.bus_grid.InsertSegment(static_cast<uint32_t>(i), prev, next);
+                prev = next;
             }
         }
+    }
 
-        std::sort(all_stops.begin(), all_stops.end(), [](const auto& l, const auto& r) {
-            return l->name < r->name; });
+    void MapRenderer::RenderViewport(const MapScene& scene, const Viewport& viewport, std::string& buffer) const {
+        //the box is projected like the whole map, whose scale fits the catalogue's bounding box
+        //into the canvas; zoom multiplies that scale, so at zoom 0 the tile is a piece of the full map
+        const Box view = Box::Of(scene.projector(viewport.min), scene.projector(viewport.max));
+        const ViewTransform transform{ { view.min_x, view.min_y }, std::ldexp(1.0, viewport.zoom) };
+        const Box area = view.Expanded(GetDrawingMargin(rs_) / transform.scale);
+
+        std::vector<uint32_t> buses;
+        scene.bus_grid.Query(area, buses);
+        std::vector<uint32_t> stops;
+        scene.stop_grid.Query(area, stops);
+        stops.erase(std::remove_if(stops.begin(), stops.end(), [&](uint32_t i) {
+            return !area.Contains(scene.stop_points[i]); }), stops.end());
+
+        svg::Document routemap;
+        routemap.SetDecimals(rs_.decimal_places);
+        //the canvas is the requested box at the tile's scale, at least a pixel each way
+        routemap.SetSize(std::max((view.max_x - view.min_x) * transform.scale, 1.0),
+            std::max((view.max_y - view.min_y) * transform.scale, 1.0));
+        AddStyleSheet(routemap);
 
-        //Print stop circle
-        for (const auto& stop : all_stops) {
-            const svg::Point sc = proj(stop->coordiante);
-            routemap.Add(svg::Circle{}.SetCenter(sc).SetRadius(rs_.stop_radius).SetFillColor("white"));
+        //a route leaving and entering the viewport is drawn as several lines,
+        //one per run of consecutive visible segments
+        for (uint32_t i : buses) {
+            const auto& route_stops = scene.buses[i]->stops;
+            std::vector<svg::Point> run;
+            svg::Point prev = scene.GetPoint(route_stops[0]);
+            if (route_stops.size() == 1 && area.Contains(prev)) {
+                run.emplace_back(transform(prev));
+            }
+            for (size_t j = 1; j < route_stops.size(); ++j) {
+                const svg::Point next = scene.GetPoint(route_stops[j]);
+                if (Box::Of(prev, next).Intersects(area)) {
+                    if (run.empty()) {
+                        run.emplace_back(transform(prev));
+                    }
+                    run.emplace_back(transform(next));
+                }
+                else if (!run.empty()) {
+                    AddRouteLine(routemap, i, run);
+                    run.clear();
+                }
+                prev = next;
+            }
+            if (!run.empty()) {
+                AddRouteLine(routemap, i, run);
+            }
+        }
+
+        for (uint32_t i : buses) {
+            const Bus* bus = scene.buses[i];
+            const svg::Point begin = scene.GetPoint(bus->stops[0]);
+            if (area.Contains(begin)) {
+                routemap.Add(CreateRouteBusNameMain(bus->name, transform(begin)));
+                routemap.Add(CreateRouteBusNameAdd(bus->name, transform(begin), i));
+            }
+            if (!bus->is_roundtrip && bus->stops[0] != bus->stops[bus->stops.size() / 2]) {
+                const svg::Point end = scene.GetPoint(bus->stops[bus->stops.size() / 2]);
+                if (area.Contains(end)) {
+                    routemap.Add(CreateRouteBusNameMain(bus->name, transform(end)));
+                    routemap.Add(CreateRouteBusNameAdd(bus->name, transform(end), i));
+                }
+            }
         }
 
-        //Print stop name
-        for (const auto& stop : all_stops) {
-            const svg::Point sc = proj(stop->coordiante);
-            routemap.Add(CreateRouteStopNameMain(stop->name, sc));
-            routemap.Add(CreateRouteStopNameAdd(stop->name, sc));
+        for (uint32_t i : stops) {
+            routemap.Add(CreateStopCircle(transform(scene.stop_points[i])));
+        }
+        for (uint32_t i : stops) {
+            routemap.Add(CreateRouteStopNameMain(scene.stops[i]->name, transform(scene.stop_points[i])));
+            routemap.Add(CreateRouteStopNameAdd(scene.stops[i]->name, transform(scene.stop_points[i])));
         }
-        
-        std::ostringstream out;
-        routemap.Render(out);
-        return out;
+
+        routemap.Render(buffer);
     }
 
     SphereProjector MapRenderer::CreateProjector(const std::vector<geo::Coordinates>& vc) const {
@@ -83,41 +407,105 @@ namespace renderer {
         return proj;
     }
 
-    size_t MapRenderer::GetNextColorPalette(size_t n) const {
-        return n >= rs_.color_palette.size() - 1 ? n = 0 : ++n;
+    svg::Color MapRenderer::GetPaletteColor(size_t bus_index) const {
+        if (rs_.color_palette.empty()) {
+            return svg::NoneColor;
+        }
+        return rs_.color_palette[bus_index % rs_.color_palette.size()];
+    }
+
+    svg::Polyline MapRenderer::CreateRouteLine(size_t bus_index) const {
+        svg::Polyline route;
+        if (rs_.shared_styles) {
+            route.SetClass(line_classes_[bus_index % line_classes_.size()]);
+            return route;
+        }
+        route.SetStrokeColor(GetPaletteColor(bus_index)).SetFillColor("none").SetStrokeWidth(rs_.line_width);
+        route.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        return route;
+    }
+
+    svg::Circle MapRenderer::CreateStopCircle(svg::Point co) const {
+        svg::Circle circle;
+        circle.SetCenter(co).SetRadius(rs_.stop_radius);
+        if (rs_.shared_styles) {
+            circle.SetClass(stop_class_);
+        }
+        else {
+            circle.SetFillColor("white");
+        }
+        return circle;
+    }
+
+    void MapRenderer::AddRouteLine(svg::Document& routemap, size_t bus_index, const std::vector<svg::Point>& points) const {
+        svg::Polyline route = CreateRouteLine(bus_index);
+        if (rs_.simplify_tolerance > 0) {
+            std::vector<svg::Point> simplified;
+            SimplifyLine(points, rs_.simplify_tolerance, simplified);
+            route.SetPoints(std::move(simplified));
+        }
+        else {
+            route.SetPoints(points);
+        }
+        routemap.Add(std::move(route));
+    }
+
+    namespace {
+
+        //in the shared_styles mode the label offset is added to the position instead of dx and dy,
+        //the font and the colors come from the classes
+        svg::Text CreateStyledLabel(svg::SharedString class_name, const std::string& name, svg::Point co, svg::Point offset) {
+            svg::Text text;
+            text.SetClass(class_name).SetPosition({ co.x + offset.x, co.y + offset.y });
+            text.RemoveOffset().RemoveFontSize().SetData(name);
+            return text;
+        }
+
     }
 
     svg::Text MapRenderer::CreateRouteBusNameMain(const std::string& name, svg::Point co) const {
+        if (rs_.shared_styles) {
+            return CreateStyledLabel(bus_underlayer_class_, name, co, rs_.bus_label_offset);
+        }
         svg::Text text;
         text.SetFillColor(rs_.underlayer_color).SetStrokeColor(rs_.underlayer_color).SetStrokeWidth(rs_.underlayer_width);
         text.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
         text.SetPosition({ co.x, co.y }).SetOffset({ rs_.bus_label_offset.x,rs_.bus_label_offset.y });
-        text.SetFontSize(rs_.bus_label_font_size).SetFontFamily("Verdana").SetFontWeight("bold").SetData(name);
+        text.SetFontSize(rs_.bus_label_font_size).SetFontFamily(font_family_).SetFontWeight(font_weight_).SetData(name);
         return text;
     }
 
     svg::Text MapRenderer::CreateRouteBusNameAdd(const std::string& name, svg::Point co, size_t color_id) const {
+        if (rs_.shared_styles) {
+            return CreateStyledLabel(bus_label_classes_[color_id % bus_label_classes_.size()], name, co, rs_.bus_label_offset);
+        }
         svg::Text text;
-        text.SetFillColor(rs_.color_palette[color_id]);
+        text.SetFillColor(GetPaletteColor(color_id));
         text.SetPosition({ co.x, co.y }).SetOffset({ rs_.bus_label_offset.x,rs_.bus_label_offset.y });
-        text.SetFontSize(rs_.bus_label_font_size).SetFontFamily("Verdana").SetFontWeight("bold").SetData(name);
+        text.SetFontSize(rs_.bus_label_font_size).SetFontFamily(font_family_).SetFontWeight(font_weight_).SetData(name);
         return text;
     }
 
     svg::Text MapRenderer::CreateRouteStopNameMain(const std::string& name, svg::Point co) const {
+        if (rs_.shared_styles) {
+            return CreateStyledLabel(stop_underlayer_class_, name, co, rs_.stop_label_offset);
+        }
         svg::Text text;
         text.SetFillColor(rs_.underlayer_color).SetStrokeColor(rs_.underlayer_color).SetStrokeWidth(rs_.underlayer_width);
         text.SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
         text.SetPosition({ co.x, co.y }).SetOffset({ rs_.stop_label_offset.x,rs_.stop_label_offset.y });
-        text.SetFontSize(rs_.stop_label_font_size).SetFontFamily("Verdana").SetData(name);
+        text.SetFontSize(rs_.stop_label_font_size).SetFontFamily(font_family_).SetData(name);
         return text;
     }
 
     svg::Text MapRenderer::CreateRouteStopNameAdd(const std::string& name, svg::Point co) const {
+        if (rs_.shared_styles) {
+            return CreateStyledLabel(stop_label_class_, name, co, rs_.stop_label_offset);
+        }
         svg::Text text;
         text.SetFillColor("black");
         text.SetPosition({ co.x, co.y }).SetOffset({ rs_.stop_label_offset.x,rs_.stop_label_offset.y });
-        text.SetFontSize(rs_.stop_label_font_size).SetFontFamily("Verdana").SetData(name);
+        text.SetFontSize(rs_.stop_label_font_size).SetFontFamily(font_family_).SetData(name);
         return text;
     }
 }
\ No newline at end of file
@@ -1,13 +1,16 @@
 #pragma once
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
 
 #include "../data/domain.h"
 #include "../data/geo.h"
+#include "../img/spatial_grid.h"
 #include "../img/svg.h"
 
-class SphereProjector;
-
 struct RenderSettings {
 	double width;
 	double height;
@@ -21,36 +24,20 @@ struct RenderSettings {
 	svg::Color underlayer_color;
 	double underlayer_width;
 	std::vector<svg::Color> color_palette;
+	//route points closer than this many pixels to the simplified line are dropped, 0 keeps all
+	double simplify_tolerance = 0;
+	//shared attributes go to a style sheet, elements only refer to its classes
+	bool shared_styles = false;
+	//decimal places of coordinates and sizes, by default 6 significant digits are written
+	int decimal_places = svg::DEFAULT_DECIMALS;
 };
 
 inline const double EPSILON = 1e-6;
 
-namespace renderer {
-
-class MapRenderer {
-public:
-	MapRenderer(const RenderSettings& rs)
-		: rs_(rs) {};
-
-    std::ostringstream PrintBusRoutes(std::vector<const Bus*>& bus_list) const;
-
-private:
-	RenderSettings rs_;
-
-	SphereProjector CreateProjector(const std::vector<geo::Coordinates>& vc) const;
-	size_t GetNextColorPalette(size_t n) const ;
-
-    svg::Text CreateRouteBusNameMain(const std::string& name, svg::Point co) const;
-    svg::Text CreateRouteBusNameAdd(const std::string& name, svg::Point co, size_t color_id) const;
-    svg::Text CreateRouteStopNameMain(const std::string& name, svg::Point co) const;
-    svg::Text CreateRouteStopNameAdd(const std::string& name, svg::Point co) const;
-
-};
-
-} // namespace
-
 class SphereProjector {
 public:
+    SphereProjector() = default;
+
     // points_begin и points_end задают начало и конец интервала элементов geo::Coordinates
     template <typename PointInputIt>
     SphereProjector(PointInputIt points_begin, PointInputIt points_end,
@@ -112,7 +99,7 @@ public:
     }
 
 private:
-    double padding_;
+    double padding_ = 0;
     double min_lon_ = 0;
     double max_lat_ = 0;
     double zoom_coeff_ = 0;
@@ -120,4 +107,120 @@ private:
     bool IsZero(double value) {
         return std::abs(value) < EPSILON;
     }
-};
\ No newline at end of file
+};
+
+
+namespace renderer {
+
+// Geometry shared by all layers of the map, every stop is projected once
+struct MapScene {
+	//buses with stops, sorted by name
+	std::vector<const Bus*> buses;
+	//stops visited by the buses, sorted by name
+	std::vector<const Stop*> stops;
+	//stop_points[i] is the projection of stops[i]
+	std::vector<svg::Point> stop_points;
+	//Stop::id -> index in stops
+	std::vector<uint32_t> stop_index;
+
+	//projection of the whole network, viewports are cut out of it
+	SphereProjector projector;
+
+	//filled by MapRenderer::IndexScene
+	SpatialGrid stop_grid;
+	//a bus is registered in every cell crossed by its route
+	SpatialGrid bus_grid;
+
+	svg::Point GetPoint(const Stop* stop) const {
+		return stop_points[stop_index[stop->id]];
+	}
+
+	util::MemoryUsage GetMemoryUsage() const {
+		util::MemoryUsage usage;
+		usage.AddVector(buses);
+		usage.AddVector(stops);
+		usage.AddVector(stop_points);
+		usage.AddVector(stop_index);
+		usage += stop_grid.GetMemoryUsage();
+		usage += bus_grid.GetMemoryUsage();
+		return usage;
+	}
+};
+
+// Part of the network requested by a client: the stops and routes inside the
+// geographic box, drawn at 2^zoom times the scale of the whole-network map
+struct Viewport {
+	geo::Coordinates min;
+	geo::Coordinates max;
+	int zoom = 0;
+};
+
+//named variants of the render settings, they may change colors, sizes and styles but
+//not the canvas, so every theme is drawn over the scene projected for the base settings
+using ThemeList = std::vector<std::pair<std::string, RenderSettings>>;
+
+class MapRenderer {
+public:
+	//throws std::invalid_argument if a theme changes width, height or padding
+	MapRenderer(const RenderSettings& rs, const ThemeList& themes = {});
+
+    std::string PrintBusRoutes(std::vector<const Bus*>& bus_list) const;
+
+    MapScene CreateScene(std::vector<const Bus*> bus_list) const;
+    //the map is appended to the buffer, so the caller can reuse or hand it over without a copy
+    void RenderScene(const MapScene& scene, std::string& buffer) const;
+
+    //builds the spatial index used by RenderViewport
+    void IndexScene(MapScene& scene) const;
+    //draws only what crosses the viewport, the work done depends on the visible part
+    void RenderViewport(const MapScene& scene, const Viewport& viewport, std::string& buffer) const;
+
+    //themes are numbered from 1 in the order they were given, 0 is the base settings
+    size_t GetThemeCount() const;
+    //an empty name is the base settings, nullopt if there is no such theme
+    std::optional<size_t> FindTheme(std::string_view name) const;
+    const MapRenderer& GetTheme(size_t index) const;
+    //one map per theme, the scene is built and projected once and shared by all of them
+    std::vector<std::string> RenderThemes(const MapScene& scene) const;
+
+private:
+	RenderSettings rs_;
+	std::vector<std::pair<std::string, std::unique_ptr<MapRenderer>>> themes_;
+	//label styles are interned once and shared by every text of the map
+	svg::SharedString font_family_{ "Verdana" };
+	svg::SharedString font_weight_{ "bold" };
+
+	//classes of the shared_styles mode, line and bus label classes are per palette color
+	std::string style_sheet_;
+	std::vector<svg::SharedString> line_classes_;
+	std::vector<svg::SharedString> bus_label_classes_;
+	svg::SharedString bus_underlayer_class_{ "u b" };
+	svg::SharedString stop_underlayer_class_{ "u n" };
+	svg::SharedString stop_label_class_{ "n k" };
+	svg::SharedString stop_class_{ "s" };
+
+	void CreateStyleSheet();
+	//the style sheet goes first, so that it is known before any element is drawn
+	void AddStyleSheet(svg::Document& routemap) const;
+
+	SphereProjector CreateProjector(const std::vector<geo::Coordinates>& vc) const;
+	svg::Color GetPaletteColor(size_t bus_index) const;
+
+	//each layer is drawn for the buses or stops of the scene in [begin, end)
+	void AddRouteLines(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const;
+	void AddBusLabels(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const;
+	void AddStopCircles(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const;
+	void AddStopLabels(svg::Document& routemap, const MapScene& scene, size_t begin, size_t end) const;
+
+    svg::Polyline CreateRouteLine(size_t bus_index) const;
+    svg::Circle CreateStopCircle(svg::Point co) const;
+    //adds the route line through the points, simplified if the settings ask for it
+    void AddRouteLine(svg::Document& routemap, size_t bus_index, const std::vector<svg::Point>& points) const;
+    svg::Text CreateRouteBusNameMain(const std::string& name, svg::Point co) const;
+    svg::Text CreateRouteBusNameAdd(const std::string& name, svg::Point co, size_t color_id) const;
+    svg::Text CreateRouteStopNameMain(const std::string& name, svg::Point co) const;
+    svg::Text CreateRouteStopNameAdd(const std::string& name, svg::Point co) const;
+
+};
+
+} // namespace
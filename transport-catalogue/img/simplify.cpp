@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <utility>
+
+#include "simplify.h"
+
+namespace renderer {
+
+    namespace {
+
+        double SquaredDistance(svg::Point p, svg::Point a, svg::Point b) {
+            const double dx = b.x - a.x;
+            const double dy = b.y - a.y;
+            const double length = dx * dx + dy * dy;
+            double t = 0;
+            //a closed route starts and ends at the same point
+            if (length > 0) {
+                t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / length, 0.0, 1.0);
+            }
+            const double x = a.x + t * dx - p.x;
+            const double y = a.y + t * dy - p.y;
+            return x * x + y * y;
+        }
+
+    }
+
+    void SimplifyLine(const std::vector<svg::Point>& points, double tolerance, std::vector<svg::Point>& result) {
+        result.clear();
+        if (points.size() < 3 || tolerance <= 0) {
+            result.assign(points.begin(), points.end());
+            return;
+        }
+
+        const double squared_tolerance = tolerance * tolerance;
+        std::vector<char> keep(points.size(), 0);
+        keep.front() = 1;
+        keep.back() = 1;
+
+        //ranges are split at the farthest point until every point is close enough,
+        //an explicit stack keeps long routes from running out of call depth
+        std::vector<std::pair<size_t, size_t>> ranges{ { 0, points.size() - 1 } };
+        while (!ranges.empty()) {
+            const auto [first, last] = ranges.back();
+            ranges.pop_back();
+
+            size_t farthest = first;
+            double max_distance = squared_tolerance;
+            for (size_t i = first + 1; i < last; ++i) {
+                const double distance = SquaredDistance(points[i], points[first], points[last]);
+                if (distance > max_distance) {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            }
+            if (farthest != first) {
+                keep[farthest] = 1;
+                ranges.emplace_back(first, farthest);
+                ranges.emplace_back(farthest, last);
+            }
+        }
+
+        for (size_t i = 0; i != points.size(); ++i) {
+            if (keep[i]) {
+                result.push_back(points[i]);
+            }
+        }
+    }
+
+} // namespace
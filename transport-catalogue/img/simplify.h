@@ -0,0 +1,12 @@
+#pragma once
+#include <vector>
+
+#include "svg.h"
+
+namespace renderer {
+
+// Douglas-Peucker simplification: drops the points that lie closer than tolerance
+// to the line kept around them. The first and the last points are always kept
+void SimplifyLine(const std::vector<svg::Point>& points, double tolerance, std::vector<svg::Point>& result);
+
+} // namespace
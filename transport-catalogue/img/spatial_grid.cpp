@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "spatial_grid.h"
+
+namespace renderer {
+
+    namespace {
+        const size_t MAX_GRID_SIDE = 1024;
+        const double MIN_EXTENT = 1e-6;
+
+        size_t GridSide(double extent, double cell_size) {
+            const double side = std::ceil(extent / cell_size);
+            return side >= MAX_GRID_SIDE ? MAX_GRID_SIDE : std::max<size_t>(1, static_cast<size_t>(side));
+        }
+    }
+
+    Box Box::Of(svg::Point a, svg::Point b) {
+        return { std::min(a.x, b.x), std::min(a.y, b.y), std::max(a.x, b.x), std::max(a.y, b.y) };
+    }
+
+    SpatialGrid::SpatialGrid(const Box& bounds, double cell_size)
+        : bounds_(bounds) {
+        //degenerate bounds still get a cell of non-zero size
+        const double width = std::max(bounds.max_x - bounds.min_x, MIN_EXTENT);
+        const double height = std::max(bounds.max_y - bounds.min_y, MIN_EXTENT);
+        cell_size = std::max(cell_size, MIN_EXTENT);
+        columns_ = GridSide(width, cell_size);
+        rows_ = GridSide(height, cell_size);
+        cell_width_ = width / static_cast<double>(columns_);
+        cell_height_ = height / static_cast<double>(rows_);
+        cells_.resize(columns_ * rows_);
+    }
+
+    size_t SpatialGrid::Column(double x) const {
+        const double column = std::floor((x - bounds_.min_x) / cell_width_);
+        return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+    }
+
+    size_t SpatialGrid::Row(double y) const {
+        const double row = std::floor((y - bounds_.min_y) / cell_height_);
+        return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    void SpatialGrid::AddToCell(uint32_t item, size_t column, size_t row) {
+        auto& cell = cells_[row * columns_ + column];
+        //segments of one item are inserted one after another
+        if (cell.empty() || cell.back() != item) {
+            cell.push_back(item);
+        }
+    }
+
+    void SpatialGrid::Insert(uint32_t item, svg::Point point) {
+        if (cells_.empty() || !bounds_.Contains(point)) {
+            return;
+        }
+        AddToCell(item, Column(point.x), Row(point.y));
+    }
+
+    void SpatialGrid::InsertSegment(uint32_t item, svg::Point from, svg::Point to) {
+        if (cells_.empty() || !Box::Of(from, to).Intersects(bounds_)) {
+            return;
+        }
+        //walks the cells crossed by the segment in order (Amanatides-Woo),
+        //the number of steps is fixed by the first and the last cell
+        const double x = (from.x - bounds_.min_x) / cell_width_;
+        const double y = (from.y - bounds_.min_y) / cell_height_;
+        const double dx = (to.x - from.x) / cell_width_;
+        const double dy = (to.y - from.y) / cell_height_;
+        const double inf = std::numeric_limits<double>::infinity();
+
+        size_t column = Column(from.x);
+        size_t row = Row(from.y);
+        const size_t last_column = Column(to.x);
+        const size_t last_row = Row(to.y);
+
+        const double delta_x = dx != 0 ? 1 / std::abs(dx) : inf;
+        const double delta_y = dy != 0 ? 1 / std::abs(dy) : inf;
+        double next_x = dx > 0 ? (std::floor(x) + 1 - x) * delta_x : dx < 0 ? (x - std::floor(x)) * delta_x : inf;
+        double next_y = dy > 0 ? (std::floor(y) + 1 - y) * delta_y : dy < 0 ? (y - std::floor(y)) * delta_y : inf;
+
+        size_t steps = (column > last_column ? column - last_column : last_column - column)
+            + (row > last_row ? row - last_row : last_row - row);
+        AddToCell(item, column, row);
+        for (; steps != 0; --steps) {
+            const bool step_column = column != last_column && (row == last_row || next_x < next_y);
+            if (step_column) {
+                column = column < last_column ? column + 1 : column - 1;
+                next_x += delta_x;
+            }
+            else {
+                row = row < last_row ? row + 1 : row - 1;
+                next_y += delta_y;
+            }
+            AddToCell(item, column, row);
+        }
+    }
+
+    void SpatialGrid::Query(const Box& box, std::vector<uint32_t>& items) const {
+        items.clear();
+        if (cells_.empty() || !box.Intersects(bounds_)) {
+            return;
+        }
+        for (size_t row = Row(box.min_y), last_row = Row(box.max_y); row <= last_row; ++row) {
+            for (size_t column = Column(box.min_x), last_column = Column(box.max_x); column <= last_column; ++column) {
+                const auto& cell = cells_[row * columns_ + column];
+                items.insert(items.end(), cell.begin(), cell.end());
+            }
+        }
+        std::sort(items.begin(), items.end());
+        items.erase(std::unique(items.begin(), items.end()), items.end());
+    }
+
+    util::MemoryUsage SpatialGrid::GetMemoryUsage() const {
+        util::MemoryUsage usage;
+        usage.AddVector(cells_);
+        for (const auto& cell : cells_) {
+            usage.AddVector(cell);
+        }
+        return usage;
+    }
+
+} // namespace
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "svg.h"
+#include "../util/memory_usage.h"
+
+namespace renderer {
+
+struct Box {
+	double min_x = 0;
+	double min_y = 0;
+	double max_x = 0;
+	double max_y = 0;
+
+	static Box Of(svg::Point a, svg::Point b);
+
+	bool Contains(svg::Point p) const {
+		return p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y;
+	}
+
+	bool Intersects(const Box& other) const {
+		return min_x <= other.max_x && other.min_x <= max_x
+			&& min_y <= other.max_y && other.min_y <= max_y;
+	}
+
+	Box Expanded(double margin) const {
+		return { min_x - margin, min_y - margin, max_x + margin, max_y + margin };
+	}
+};
+
+// Uniform grid over screen coordinates. An item is registered in every cell it
+// touches, a query returns the items of the cells touched by the query box
+class SpatialGrid {
+public:
+	SpatialGrid() = default;
+	//square cells of the given size, at most 1024 per side
+	SpatialGrid(const Box& bounds, double cell_size);
+
+	void Insert(uint32_t item, svg::Point point);
+	//registers the item in the cells crossed by the segment, not in the whole box of it
+	void InsertSegment(uint32_t item, svg::Point from, svg::Point to);
+
+	//fills items with the candidates for the box, sorted and without repeats
+	void Query(const Box& box, std::vector<uint32_t>& items) const;
+
+	util::MemoryUsage GetMemoryUsage() const;
+
+private:
+	Box bounds_;
+	size_t columns_ = 0;
+	size_t rows_ = 0;
+	double cell_width_ = 1;
+	double cell_height_ = 1;
+	std::vector<std::vector<uint32_t>> cells_;
+
+	size_t Column(double x) const;
+	size_t Row(double y) const;
+	void AddToCell(uint32_t item, size_t column, size_t row);
+};
+
+} // namespace
@@ -1,5 +1,8 @@
 #define _USE_MATH_DEFINES
+#include <charconv>
 #include <cmath>
+#include <mutex>
+#include <unordered_set>
 
 #include "svg.h"
 
@@ -16,7 +19,148 @@ void Object::Render(const RenderContext& context) const {
     context.out << std::endl;
 }
 
-void TextToSVGFormat(std::ostream& out, std::string_view text) {
+namespace {
+
+template <typename Int>
+void WriteInt(std::string& buffer, Int value) {
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+std::string_view ToString(StrokeLineCap value) {
+    switch (value){
+    case StrokeLineCap::BUTT:
+        return "butt"sv;
+    case StrokeLineCap::ROUND:
+        return "round"sv;
+    case StrokeLineCap::SQUARE:
+        return "square"sv;
+    }
+    return {};
+}
+
+std::string_view ToString(StrokeLineJoin value) {
+    switch (value){
+    case StrokeLineJoin::ARCS:
+        return "arcs"sv;
+    case StrokeLineJoin::BEVEL:
+        return "bevel"sv;
+    case StrokeLineJoin::MITER:
+        return "miter"sv;
+    case StrokeLineJoin::MITER_CLIP:
+        return "miter-clip"sv;
+    case StrokeLineJoin::ROUND:
+        return "round"sv;
+    }
+    return {};
+}
+
+}
+
+// ---------- SharedString ------------------
+
+SharedString::SharedString(std::string_view value) {
+    // Элементы unordered_set не перемещаются при рехешировании,
+    // поэтому указатель на строку остаётся действительным
+    static std::mutex pool_mutex;
+    static std::unordered_set<std::string> pool;
+
+    std::lock_guard lock(pool_mutex);
+    auto it = pool.find(std::string(value));
+    if (it == pool.end()) {
+        it = pool.emplace(value).first;
+    }
+    value_ = &*it;
+}
+
+// ---------- WriteNumber ------------------
+
+char* WriteNumber(char* first, double value, int decimals) {
+    static constexpr int64_t POWERS_OF_TEN[MAX_DECIMALS + 1] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    // Целая часть масштабированного числа должна точно помещаться в double
+    static constexpr double MAX_SCALED = 1e15;
+
+    char* last = first + NUMBER_BUFFER_SIZE;
+    if (decimals < 0 || decimals > MAX_DECIMALS || !std::isfinite(value)
+        || std::abs(value) * static_cast<double>(POWERS_OF_TEN[decimals]) >= MAX_SCALED) {
+        // Формат general с точностью 6 совпадает с %g и с std::ostream по умолчанию
+        return std::to_chars(first, last, value, std::chars_format::general, 6).ptr;
+    }
+
+    const int64_t scale = POWERS_OF_TEN[decimals];
+    int64_t scaled = std::llround(value * static_cast<double>(scale));
+    if (scaled < 0) {
+        *first++ = '-';
+        scaled = -scaled;
+    }
+    first = std::to_chars(first, last, scaled / scale).ptr;
+
+    int64_t fraction = scaled % scale;
+    if (fraction != 0) {
+        int digits = decimals;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            --digits;
+        }
+        *first++ = '.';
+        // Дробная часть дополняется ведущими нулями до digits знаков
+        for (char* digit = first + digits; digit != first; fraction /= 10) {
+            *--digit = static_cast<char>('0' + fraction % 10);
+        }
+        first += digits;
+    }
+    return first;
+}
+
+// ---------- Writer ------------------
+
+Writer& Writer::operator<<(double value) {
+    char digits[NUMBER_BUFFER_SIZE];
+    buffer_.append(digits, WriteNumber(digits, value, decimals_));
+    return *this;
+}
+
+Writer& Writer::operator<<(int value) {
+    WriteInt(buffer_, value);
+    return *this;
+}
+
+Writer& Writer::operator<<(uint32_t value) {
+    WriteInt(buffer_, value);
+    return *this;
+}
+
+Writer& Writer::operator<<(const Color& value) {
+    if (const auto* str = std::get_if<std::string>(&value)) {
+        buffer_.append(*str);
+    }
+    else if (const auto* rgb = std::get_if<Rgb>(&value)) {
+        *this << "rgb("sv << static_cast<int>(rgb->red) << ',' << static_cast<int>(rgb->green)
+            << ',' << static_cast<int>(rgb->blue) << ')';
+    }
+    else if (const auto* rgba = std::get_if<Rgba>(&value)) {
+        *this << "rgba("sv << static_cast<int>(rgba->red) << ',' << static_cast<int>(rgba->green)
+            << ',' << static_cast<int>(rgba->blue) << ',' << rgba->opacity << ')';
+    }
+    else {
+        buffer_.append("none"sv);
+    }
+    return *this;
+}
+
+Writer& Writer::operator<<(StrokeLineCap value) {
+    buffer_.append(ToString(value));
+    return *this;
+}
+
+Writer& Writer::operator<<(StrokeLineJoin value) {
+    buffer_.append(ToString(value));
+    return *this;
+}
+
+void TextToSVGFormat(Writer& out, std::string_view text) {
     for (char c : text) {
         switch (c){
         case '"':
@@ -42,47 +186,16 @@ void TextToSVGFormat(std::ostream& out, std::string_view text) {
 }
 
 std::ostream& operator<<(std::ostream& out, const StrokeLineCap& value) {
-    std::string_view slc;
-    switch (value){
-    case StrokeLineCap::BUTT:
-        slc = "butt"sv;
-        break;
-    case StrokeLineCap::ROUND:
-        slc = "round"sv;
-        break;
-    case StrokeLineCap::SQUARE:
-        slc = "square"sv;
-        break;    
-    }
-    return out << slc;
+    return out << ToString(value);
 }
 
 std::ostream& operator<<(std::ostream& out, const StrokeLineJoin& value) {
-    std::string_view slj;
-    switch (value){
-    case StrokeLineJoin::ARCS:
-        slj = "arcs"sv;
-        break;
-    case StrokeLineJoin::BEVEL:
-        slj = "bevel"sv;
-        break;
-    case StrokeLineJoin::MITER:
-        slj = "miter"sv;
-        break;
-    case StrokeLineJoin::MITER_CLIP:
-        slj = "miter-clip"sv;
-        break;
-    case StrokeLineJoin::ROUND:
-        slj = "round"sv;
-        break;
-    }
-    return out << slj;
+    return out << ToString(value);
 }
 
 std::ostream& operator<<(std::ostream& out, const Color& value) {
-    std::ostringstream strm;
-    std::visit(ColorPrinter{ strm }, value);
-    return out << strm.str();
+    std::visit(ColorPrinter{ out }, value);
+    return out;
 }
 
 // ---------- Circle ------------------
@@ -97,14 +210,20 @@ Circle& Circle::SetRadius(double radius)  {
     return *this;
 }
 
-void Circle::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
+void Circle::Serialize(Writer& out) const {
     out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-    out << "r=\""sv << radius_ << "\""sv;
-    RenderAttrs(context.out);
+    out << "r=\""sv << radius_ << '"';
+    RenderAttrs(out);
     out << "/>"sv;
 }
 
+void Circle::RenderObject(const RenderContext& context) const {
+    std::string buffer;
+    Writer out(buffer);
+    Serialize(out);
+    context.out << buffer;
+}
+
 // ---------- Polyline ------------------
 
 Polyline& Polyline::AddPoint(Point point) {
@@ -112,24 +231,40 @@ Polyline& Polyline::AddPoint(Point point) {
     return *this;
 }
 
-void Polyline::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
+Polyline& Polyline::Reserve(size_t count) {
+    points_.reserve(count);
+    return *this;
+}
+
+Polyline& Polyline::SetPoints(std::vector<Point> points) {
+    points_ = std::move(points);
+    return *this;
+}
+
+void Polyline::Serialize(Writer& out) const {
     out << "<polyline points=\""sv;
     bool is_first_point = true;
     for (const Point& point : points_) {
         if (is_first_point) {
-            out << point.x << "," << point.y;
             is_first_point = false;
         }
         else{
-            out << " " << point.x << "," << point.y;
+            out << ' ';
         }
+        out << point.x << ',' << point.y;
     }
-    out << "\"";
-        RenderAttrs(context.out); 
+    out << '"';
+    RenderAttrs(out);
     out << "/>"sv;
 }
 
+void Polyline::RenderObject(const RenderContext& context) const {
+    std::string buffer;
+    Writer out(buffer);
+    Serialize(out);
+    context.out << buffer;
+}
+
 // ---------- Text ------------------
 
 Text& Text::SetPosition(Point pos) {
@@ -147,55 +282,145 @@ Text& Text::SetFontSize(uint32_t size) {
     return *this;
 }
 
-Text& Text::SetFontFamily(std::string font_family) {
+Text& Text::RemoveOffset() {
+    offset_.reset();
+    return *this;
+}
+
+Text& Text::RemoveFontSize() {
+    size_.reset();
+    return *this;
+}
+
+Text& Text::SetFontFamily(SharedString font_family) {
     font_family_ = font_family;
     return *this;
 }
 
-Text& Text::SetFontWeight(std::string font_weight) {
+Text& Text::SetFontWeight(SharedString font_weight) {
     font_weight_ = font_weight;
     return *this;
 }
 
 Text& Text::SetData(std::string data) {
-    data_ = data;
+    data_ = std::move(data);
     return *this;
 }
 
-void Text::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
-
-    out << "<text";
-    RenderAttrs(context.out);
+void Text::Serialize(Writer& out) const {
+    out << "<text"sv;
+    RenderAttrs(out);
     out << " x=\""sv << position_.x << "\" y=\""sv << position_.y;
-    out << "\" dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y;
-    out << "\" font-size=\""sv << size_ << "\"";
-    if (!font_family_.empty()) {
-        out << " font-family=\""sv << font_family_ << "\"";
+    out << '"';
+    if (offset_) {
+        out << " dx=\""sv << offset_->x << "\" dy=\""sv << offset_->y << '"';
+    }
+    if (size_) {
+        out << " font-size=\""sv << *size_ << '"';
     }
-    if (!font_weight_.empty()) {
-        out << " font-weight=\""sv << font_weight_ << "\"";
+    if (!font_family_.Empty()) {
+        out << " font-family=\""sv << font_family_ << '"';
     }
-    out << ">";
+    if (!font_weight_.Empty()) {
+        out << " font-weight=\""sv << font_weight_ << '"';
+    }
+    out << '>';
     TextToSVGFormat(out, data_);
-    out << "</text>";
+    out << "</text>"sv;
+}
+
+void Text::RenderObject(const RenderContext& context) const {
+    std::string buffer;
+    Writer out(buffer);
+    Serialize(out);
+    context.out << buffer;
+}
+
+// ---------- Style ------------------
+
+void Style::RenderObject(const RenderContext& context) const {
+    // Таблица стилей не содержит пользовательского текста, поэтому выводится как есть
+    context.out << "<style>"sv << css_ << "</style>"sv;
 }
 
 // ---------- Document ------------------
 
+void Document::Add(Circle circle) {
+    objects_.emplace_back(std::move(circle));
+}
+
+void Document::Add(Polyline polyline) {
+    objects_.emplace_back(std::move(polyline));
+}
+
+void Document::Add(Text text) {
+    objects_.emplace_back(std::move(text));
+}
+
 void Document::AddPtr(std::unique_ptr<Object>&& obj) {
     objects_.emplace_back(std::move(obj));
 }
 
+void Document::Reserve(size_t count) {
+    objects_.reserve(count);
+}
+
+void Document::SetDecimals(int decimals) {
+    decimals_ = decimals;
+}
+
+void Document::SetSize(double width, double height) {
+    size_ = Point{ width, height };
+}
+
 void Document::Render(std::ostream& out) const {
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
-    RenderContext indentation(out, 2, 2);
+    // Документ собирается в буфере целиком и выводится одной операцией
+    std::string buffer;
+    Render(buffer);
+    out << buffer;
+}
 
-    for (const auto &o : objects_) {
-        o->Render(indentation);
+void Document::Render(std::string& buffer) const {
+    if (size_) {
+        Writer out(buffer, decimals_);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\""sv << size_->x
+            << "\" height=\""sv << size_->y << "\" viewBox=\"0 0 "sv << size_->x << ' ' << size_->y << "\">\n"sv;
     }
-    out << "</svg>"sv;
+    else {
+        RenderHeader(buffer);
+    }
+    RenderObjects(buffer);
+    RenderFooter(buffer);
+}
+
+void Document::RenderObjects(std::string& buffer) const {
+    Writer out(buffer, decimals_);
+    for (const auto& object : objects_) {
+        if (const auto* ptr = std::get_if<std::unique_ptr<Object>>(&object)) {
+            std::ostringstream strm;
+            (*ptr)->Render(RenderContext(strm, 2, 2));
+            out << strm.str();
+            continue;
+        }
+        out << "  "sv;
+        std::visit([&out](const auto& obj) {
+            using T = std::decay_t<decltype(obj)>;
+            if constexpr (!std::is_same_v<T, std::unique_ptr<Object>>) {
+                obj.Serialize(out);
+            }
+        }, object);
+        out << '\n';
+    }
+}
+
+void Document::RenderHeader(std::string& buffer) {
+    buffer.append("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv);
+    buffer.append("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv);
+}
+
+void Document::RenderFooter(std::string& buffer) {
+    buffer.append("</svg>"sv);
 }
 
-}  // namespace svg
\ No newline at end of file
+}  // namespace svg
@@ -6,6 +6,7 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -61,7 +62,7 @@ struct ColorPrinter {
     void operator()(std::monostate) const {
         out << "none";
     }
-    void operator()(std::string str) const {
+    void operator()(const std::string& str) const {
         out << str;
     }
     void operator()(Rgb rgb) const {
@@ -161,6 +162,92 @@ enum class StrokeLineJoin {
 
 std::ostream& operator<<(std::ostream& out, const StrokeLineJoin& value);
 
+/*
+ * Строка из общего пула: одинаковые значения хранятся в одном экземпляре,
+ * поэтому копирование не выделяет память. Пул не очищается, строки живут
+ * до конца программы. Подходит для повторяющихся значений стилей
+ */
+class SharedString {
+public:
+    SharedString() = default;
+    SharedString(std::string_view value);
+    SharedString(const char* value)
+        : SharedString(std::string_view(value)) {
+    }
+    SharedString(const std::string& value)
+        : SharedString(std::string_view(value)) {
+    }
+
+    std::string_view View() const {
+        return value_ ? std::string_view(*value_) : std::string_view();
+    }
+
+    bool Empty() const {
+        return View().empty();
+    }
+
+private:
+    const std::string* value_ = nullptr;
+};
+
+// Без ограничения числа знаков после запятой числа выводятся с 6 значащими
+// цифрами, как в std::ostream с настройками по умолчанию
+inline constexpr int DEFAULT_DECIMALS = -1;
+inline constexpr int MAX_DECIMALS = 9;
+// Размер буфера, достаточный для любого числа, выводимого WriteNumber
+inline constexpr size_t NUMBER_BUFFER_SIZE = 32;
+
+// Записывает число в буфер из NUMBER_BUFFER_SIZE символов и возвращает указатель
+// за последним записанным символом. При decimals от 0 до MAX_DECIMALS число
+// округляется до этого количества знаков после запятой, незначащие нули отбрасываются
+char* WriteNumber(char* first, double value, int decimals = DEFAULT_DECIMALS);
+
+/*
+ * Дописывает SVG-представление в конец строки-буфера без промежуточных потоков.
+ * Числа выводятся функцией WriteNumber с заданным количеством знаков после запятой
+ */
+class Writer {
+public:
+    explicit Writer(std::string& buffer, int decimals = DEFAULT_DECIMALS)
+        : buffer_(buffer)
+        , decimals_(decimals) {
+    }
+
+    Writer& operator<<(std::string_view text) {
+        buffer_.append(text);
+        return *this;
+    }
+    Writer& operator<<(const std::string& text) {
+        buffer_.append(text);
+        return *this;
+    }
+    Writer& operator<<(const char* text) {
+        buffer_.append(text);
+        return *this;
+    }
+    Writer& operator<<(char c) {
+        buffer_.push_back(c);
+        return *this;
+    }
+    Writer& operator<<(SharedString text) {
+        buffer_.append(text.View());
+        return *this;
+    }
+    Writer& operator<<(double value);
+    Writer& operator<<(int value);
+    Writer& operator<<(uint32_t value);
+    Writer& operator<<(const Color& value);
+    Writer& operator<<(StrokeLineCap value);
+    Writer& operator<<(StrokeLineJoin value);
+
+private:
+    std::string& buffer_;
+    int decimals_ = DEFAULT_DECIMALS;
+};
+
+// Выводит текст, заменяя спецсимволы XML на сущности
+void TextToSVGFormat(Writer& out, std::string_view text);
+
 template <typename Owner>
 class PathProps {
 public:
@@ -186,27 +273,35 @@ public:
         stroke_linejoin_ = std::move(line_join);
         return AsOwner();
     }
+    // Задаёт классы CSS (атрибут class)
+    Owner& SetClass(SharedString class_name) {
+        class_ = class_name;
+        return AsOwner();
+    }
 
 protected:
     ~PathProps() = default;
 
-    void RenderAttrs(std::ostream& out) const {
+    void RenderAttrs(Writer& out) const {
         using namespace std::literals;
 
+        if (!class_.Empty()) {
+            out << " class=\""sv << class_ << '"';
+        }
         if (fill_color_) {
-            out << " fill=\""sv << *fill_color_ << "\""sv;
+            out << " fill=\""sv << *fill_color_ << '"';
         }
         if (stroke_color_) {
-            out << " stroke=\"" << *stroke_color_ << "\"";
+            out << " stroke=\""sv << *stroke_color_ << '"';
         }
         if (stroke_width_) {
-            out << " stroke-width=\"" << *stroke_width_ << "\"";
+            out << " stroke-width=\""sv << *stroke_width_ << '"';
         }
         if (stroke_linecap_) {
-            out << " stroke-linecap=\"" << *stroke_linecap_ << "\"";
+            out << " stroke-linecap=\""sv << *stroke_linecap_ << '"';
         }
         if (stroke_linejoin_) {
-            out << " stroke-linejoin=\"" << *stroke_linejoin_ << "\"";
+            out << " stroke-linejoin=\""sv << *stroke_linejoin_ << '"';
         }
     }
 
@@ -220,6 +315,7 @@ private:
     std::optional<double> stroke_width_;
     std::optional<StrokeLineCap> stroke_linecap_;
     std::optional<StrokeLineJoin> stroke_linejoin_;
+    SharedString class_;
 };
 
     /*
@@ -235,6 +331,9 @@ private:
         Circle& SetCenter(Point center);
         Circle& SetRadius(double radius);
 
+        // Дописывает тег в буфер
+        void Serialize(Writer& out) const;
+
     private:
         void RenderObject(const RenderContext& context) const override;
 
@@ -255,6 +354,14 @@ private:
         // Добавляет очередную вершину к ломаной линии
         Polyline& AddPoint(Point point);
 
+        // Резервирует место под вершины, когда их число известно заранее
+        Polyline& Reserve(size_t count);
+
+        // Заменяет все вершины ломаной
+        Polyline& SetPoints(std::vector<Point> points);
+
+        void Serialize(Writer& out) const;
+
     private:
         void RenderObject(const RenderContext& context) const override;
 
@@ -270,10 +377,7 @@ private:
         Text()
             : position_({ 0.0,0.0 }),
             offset_({ 0.0,0.0 }),
-            size_(1),
-            font_family_(""),
-            font_weight_(""),
-            data_("")
+            size_(1)
         {}
         // Задаёт координаты опорной точки (атрибуты x и y)
         Text& SetPosition(Point pos);
@@ -284,38 +388,91 @@ private:
         // Задаёт размеры шрифта (атрибут font-size)
         Text& SetFontSize(uint32_t size);
 
+        // Убирают атрибуты dx, dy и font-size, когда их задаёт таблица стилей
+        // или смещение уже учтено в координатах опорной точки
+        Text& RemoveOffset();
+        Text& RemoveFontSize();
+
         // Задаёт название шрифта (атрибут font-family)
-        Text& SetFontFamily(std::string font_family);
+        Text& SetFontFamily(SharedString font_family);
 
         // Задаёт толщину шрифта (атрибут font-weight)
-        Text& SetFontWeight(std::string font_weight);
+        Text& SetFontWeight(SharedString font_weight);
 
         // Задаёт текстовое содержимое объекта (отображается внутри тега text)
         Text& SetData(std::string data);
 
+        void Serialize(Writer& out) const;
+
     private:
         void RenderObject(const RenderContext& context) const override;
 
         Point position_;
-        Point offset_;
-        uint32_t size_;
-        std::string font_family_;
-        std::string font_weight_;
+        std::optional<Point> offset_;
+        std::optional<uint32_t> size_;
+        SharedString font_family_;
+        SharedString font_weight_;
         std::string data_;
     };
 
 
+    /*
+     * Класс Style моделирует элемент <style> с таблицей стилей CSS документа
+     * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/style
+     */
+    class Style final : public Object {
+    public:
+        explicit Style(std::string css)
+            : css_(std::move(css))
+        {}
+
+    private:
+        void RenderObject(const RenderContext& context) const override;
+
+        std::string css_;
+    };
+
+/*
+ * Примитивы хранятся в документе по значению, без отдельного выделения памяти
+ * на каждый элемент. Прочие наследники Object по-прежнему хранятся по указателю
+ */
 class Document : public ObjectContainer {
 public:
+    using ObjectContainer::Add;
+
+    void Add(Circle circle);
+    void Add(Polyline polyline);
+    void Add(Text text);
 
     void AddPtr(std::unique_ptr<Object>&& obj) override ;
 
+    void Reserve(size_t count);
+
+    // Задаёт количество знаков после запятой в координатах и размерах
+    void SetDecimals(int decimals);
+
+    // Задаёт размер холста: в заголовок попадут width, height и viewBox от (0, 0).
+    // Без него заголовок выводится без размеров
+    void SetSize(double width, double height);
+
     // Выводит в ostream svg-представление документа
     void Render(std::ostream& out) const;
 
+    // Дописывает svg-представление документа в конец буфера
+    void Render(std::string& buffer) const;
+
+    // Дописывает в буфер только элементы документа, без заголовка и закрывающего тега.
+    // Позволяет собирать документ из частей, подготовленных независимо
+    void RenderObjects(std::string& buffer) const;
+    static void RenderHeader(std::string& buffer);
+    static void RenderFooter(std::string& buffer);
+
 private:
+    using Element = std::variant<Circle, Polyline, Text, std::unique_ptr<Object>>;
 
-    std::vector<std::unique_ptr<Object>> objects_;
+    std::vector<Element> objects_;
+    int decimals_ = DEFAULT_DECIMALS;
+    std::optional<Point> size_;
 
 };
 
@@ -1,5 +1,6 @@
 #include "json.h"
 
+#include <algorithm>
 #include <iterator>
 
 namespace json {
@@ -9,6 +10,7 @@ using namespace std::literals;
 
 Node LoadNode(std::istream& input);
 Node LoadString(std::istream& input);
+void SkipValue(std::istream& input);
 
 std::string LoadLiteral(std::istream& input) {
     std::string s;
@@ -33,13 +35,18 @@ Node LoadArray(std::istream& input) {
     return Node(std::move(result));
 }
 
-Node LoadDict(std::istream& input) {
+// skip_keys - ключи, значения которых пропускаются без разбора
+Node LoadDict(std::istream& input, const std::vector<std::string_view>& skip_keys = {}) {
     Dict dict;
 
     for (char c; input >> c && c != '}';) {
         if (c == '"') {
             std::string key = LoadString(input).AsString();
             if (input >> c && c == ':') {
+                if (std::find(skip_keys.begin(), skip_keys.end(), key) != skip_keys.end()) {
+                    SkipValue(input);
+                    continue;
+                }
                 if (dict.find(key) != dict.end()) {
                     throw ParsingError("Duplicate key '"s + key + "' have been found");
                 }
@@ -105,6 +112,47 @@ Node LoadString(std::istream& input) {
     return Node(std::move(s));
 }
 
+// Пропускает значение, проверяя только парность скобок и кавычек: ни строки,
+// ни числа не создаются
+void SkipValue(std::istream& input) {
+    char c;
+    if (!(input >> c)) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    if (c != '[' && c != '{' && c != '"') {
+        // Число или литерал заканчиваются перед разделителем
+        while (input && std::string_view(",]} \t\r\n").find(static_cast<char>(input.peek())) == std::string_view::npos) {
+            input.get();
+        }
+        return;
+    }
+    std::streambuf& buffer = *input.rdbuf();
+    bool in_string = c == '"';
+    int depth = in_string ? 0 : 1;
+    while (true) {
+        const int ch = buffer.sbumpc();
+        if (ch == std::char_traits<char>::eof()) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        if (in_string) {
+            if (ch == '\\') {
+                buffer.sbumpc();
+            } else if (ch == '"') {
+                in_string = false;
+                if (depth == 0) {
+                    return;
+                }
+            }
+        } else if (ch == '"') {
+            in_string = true;
+        } else if (ch == '[' || ch == '{') {
+            ++depth;
+        } else if ((ch == ']' || ch == '}') && --depth == 0) {
+            return;
+        }
+    }
+}
+
 Node LoadBool(std::istream& input) {
     const auto s = LoadLiteral(input);
     if (s == "true"sv) {
@@ -226,6 +274,8 @@ struct PrintContext {
     std::ostream& out;
     int indent_step = 4;
     int indent = 0;
+    // Печать в одну строку без пробелов и переводов строк (JSON Lines)
+    bool compact = false;
 
     void PrintIndent() const {
         for (int i = 0; i < indent; ++i) {
@@ -233,8 +283,14 @@ struct PrintContext {
         }
     }
 
+    void PrintLineBreak() const {
+        if (!compact) {
+            out.put('\n');
+        }
+    }
+
     PrintContext Indented() const {
-        return {out, indent_step, indent_step + indent};
+        return {out, compact ? 0 : indent_step, compact ? 0 : indent_step + indent, compact};
     }
 };
 
@@ -245,30 +301,38 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
+// Возвращает escape-последовательность символа или пустую строку,
+// если символ выводится как есть
+std::string_view EscapeSequence(char c) {
+    switch (c) {
+        case '\r':
+            return "\\r"sv;
+        case '\n':
+            return "\\n"sv;
+        case '\t':
+            return "\\t"sv;
+        case '"':
+            return "\\\""sv;
+        case '\\':
+            return "\\\\"sv;
+        default:
+            return {};
+    }
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
     out.put('"');
-    for (const char c : value) {
-        switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '\t':
-                out << "\\t"sv;
-                break;
-            case '"':
-                // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
+    // Участки без спецсимволов выводятся целиком, а не по одному символу
+    size_t plain_begin = 0;
+    for (size_t i = 0; i != value.size(); ++i) {
+        const std::string_view escaped = EscapeSequence(value[i]);
+        if (!escaped.empty()) {
+            out.write(value.data() + plain_begin, i - plain_begin);
+            out << escaped;
+            plain_begin = i + 1;
         }
     }
+    out.write(value.data() + plain_begin, value.size() - plain_begin);
     out.put('"');
 }
 
@@ -277,6 +341,14 @@ void PrintValue<std::string>(const std::string& value, const PrintContext& ctx)
     PrintString(value, ctx.out);
 }
 
+template <>
+void PrintValue<EscapedString>(const EscapedString& value, const PrintContext& ctx) {
+    const std::string_view body = value.View();
+    ctx.out.put('"');
+    ctx.out.write(body.data(), body.size());
+    ctx.out.put('"');
+}
+
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
     ctx.out << "null"sv;
@@ -294,19 +366,21 @@ void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
 template <>
 void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "[\n"sv;
+    out.put('[');
+    ctx.PrintLineBreak();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const Node& node : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintLineBreak();
         }
         inner_ctx.PrintIndent();
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintLineBreak();
     ctx.PrintIndent();
     out.put(']');
 }
@@ -314,21 +388,23 @@ void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
 template <>
 void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
     std::ostream& out = ctx.out;
-    out << "{\n"sv;
+    out.put('{');
+    ctx.PrintLineBreak();
     bool first = true;
     auto inner_ctx = ctx.Indented();
     for (const auto& [key, node] : nodes) {
         if (first) {
             first = false;
         } else {
-            out << ",\n"sv;
+            out.put(',');
+            ctx.PrintLineBreak();
         }
         inner_ctx.PrintIndent();
         PrintString(key, ctx.out);
-        out << ": "sv;
+        out << (ctx.compact ? ":"sv : ": "sv);
         PrintNode(node, inner_ctx);
     }
-    out.put('\n');
+    ctx.PrintLineBreak();
     ctx.PrintIndent();
     out.put('}');
 }
@@ -347,8 +423,116 @@ Document Load(std::istream& input) {
     return Document{LoadNode(input)};
 }
 
+Document Load(std::istream& input, const std::vector<std::string_view>& skip_root_keys) {
+    char c;
+    if (!(input >> c)) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    if (c != '{') {
+        input.putback(c);
+        return Document{LoadNode(input)};
+    }
+    return Document{LoadDict(input, skip_root_keys)};
+}
+
+EscapedString::EscapedString(std::string value) {
+    size_t extra = 0;
+    for (const char c : value) {
+        extra += EscapeSequence(c).empty() ? 0 : 1;
+    }
+    // Все escape-последовательности двухсимвольные, поэтому строка раздвигается
+    // с конца: каждый символ переносится не более одного раза
+    size_t read = value.size();
+    value.resize(value.size() + extra);
+    size_t write = value.size();
+    while (read != write) {
+        const char c = value[--read];
+        const std::string_view escaped = EscapeSequence(c);
+        if (escaped.empty()) {
+            value[--write] = c;
+        }
+        else {
+            value[--write] = escaped[1];
+            value[--write] = escaped[0];
+        }
+    }
+    body_ = std::make_shared<const std::string>(std::move(value));
+}
+
+util::MemoryUsage EscapedString::GetMemoryUsage() const {
+    util::MemoryUsage usage;
+    if (body_) {
+        // make_shared кладёт строку и счётчики ссылок в один блок
+        usage.AddAllocation(sizeof(std::string) + sizeof(void*) + 2 * sizeof(int));
+        usage.AddString(*body_);
+    }
+    return usage;
+}
+
+util::MemoryUsage GetMemoryUsage(const Node& node) {
+    util::MemoryUsage usage;
+    if (node.IsArray()) {
+        usage.AddVector(node.AsArray());
+        for (const Node& element : node.AsArray()) {
+            usage += GetMemoryUsage(element);
+        }
+    }
+    else if (node.IsDict()) {
+        usage.AddTree(node.AsDict());
+        for (const auto& [key, value] : node.AsDict()) {
+            usage.AddString(key);
+            usage += GetMemoryUsage(value);
+        }
+    }
+    else if (node.IsString()) {
+        usage.AddString(node.AsString());
+    }
+    else if (node.IsEscapedString()) {
+        usage += node.AsEscapedString().GetMemoryUsage();
+    }
+    return usage;
+}
+
 void Print(const Document& doc, std::ostream& output) {
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+void PrintLine(const Node& node, std::ostream& output) {
+    PrintNode(node, PrintContext{output, 0, 0, true});
+}
+
+ArrayWriter::ArrayWriter(std::ostream& output)
+    : output_(output) {
+    output_ << "[\n"sv;
+}
+
+void ArrayWriter::Add(const Node& node) {
+    if (first_) {
+        first_ = false;
+    } else {
+        output_ << ",\n"sv;
+    }
+    PrintElement(node, output_);
+}
+
+void ArrayWriter::AddPrinted(std::string_view elements) {
+    if (first_) {
+        first_ = false;
+    } else {
+        output_ << ",\n"sv;
+    }
+    output_ << elements;
+}
+
+void ArrayWriter::PrintElement(const Node& node, std::ostream& output) {
+    const auto inner_ctx = PrintContext{output}.Indented();
+    inner_ctx.PrintIndent();
+    PrintNode(node, inner_ctx);
+}
+
+void ArrayWriter::Finish() {
+    output_.put('\n');
+    output_.put(']');
+}
+
 }  // namespace json
\ No newline at end of file
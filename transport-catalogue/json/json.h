@@ -2,10 +2,14 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include "../util/memory_usage.h"
+
 namespace json {
 
 class Node;
@@ -17,8 +21,31 @@ public:
     using runtime_error::runtime_error;
 };
 
+// Строка, уже экранированная для вывода в JSON (без обрамляющих кавычек).
+// Копии разделяют одно тело, при выводе оно пишется как есть, без повторного экранирования
+class EscapedString {
+public:
+    EscapedString() = default;
+    // Экранирует строку на месте: буфер только дорастает до нужного размера
+    explicit EscapedString(std::string value);
+
+    std::string_view View() const {
+        return body_ ? std::string_view(*body_) : std::string_view();
+    }
+
+    bool operator==(const EscapedString& rhs) const {
+        return View() == rhs.View();
+    }
+
+    // Память общего тела, копии его не увеличивают
+    util::MemoryUsage GetMemoryUsage() const;
+
+private:
+    std::shared_ptr<const std::string> body_;
+};
+
 class Node final
-    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, EscapedString> {
 public:
     using variant::variant;
     using Value = variant;
@@ -92,6 +119,18 @@ public:
         return std::get<std::string>(*this);
     }
 
+    bool IsEscapedString() const {
+        return std::holds_alternative<EscapedString>(*this);
+    }
+    const EscapedString& AsEscapedString() const {
+        using namespace std::literals;
+        if (!IsEscapedString()) {
+            throw std::logic_error("Not an escaped string"s);
+        }
+
+        return std::get<EscapedString>(*this);
+    }
+
     bool IsDict() const {
         return std::holds_alternative<Dict>(*this);
     }
@@ -140,7 +179,36 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 }
 
 Document Load(std::istream& input);
+// Same as Load, but the values of skip_root_keys in the root dict are only scanned
+// for matching brackets and quotes, they are neither built nor put into the document
+Document Load(std::istream& input, const std::vector<std::string_view>& skip_root_keys);
+
+// Heap memory of the node and of everything below it
+util::MemoryUsage GetMemoryUsage(const Node& node);
 
 void Print(const Document& doc, std::ostream& output);
 
+// Prints a node on a single line without whitespace, one JSON Lines record
+void PrintLine(const Node& node, std::ostream& output);
+
+// Prints a root array element by element without keeping it in memory.
+// The output is byte-identical to Print() of a Document holding the same array
+class ArrayWriter {
+public:
+    explicit ArrayWriter(std::ostream& output);
+
+    void Add(const Node& node);
+    // Adds elements printed with PrintElement and joined with ",\n", so that
+    // parts of the array can be printed on other threads
+    void AddPrinted(std::string_view elements);
+    void Finish();
+
+    // Prints an element the way Add does, without the separator
+    static void PrintElement(const Node& node, std::ostream& output);
+
+private:
+    std::ostream& output_;
+    bool first_ = true;
+};
+
 }  // namespace json
\ No newline at end of file
@@ -5,7 +5,7 @@ using namespace std::literals;
 namespace json {
 	using namespace std;
 
-	Builder::KeyItemContext Builder::Key(const std::string& str) {
+	Builder::KeyItemContext Builder::Key(std::string str) {
 		if (complite_container_) {
 			throw std::logic_error("Container already build");
 		}
@@ -16,35 +16,45 @@ namespace json {
 			throw std::logic_error("Key must use only in Dict container");
 		}
 
-		keys_.emplace_back(str);
+		keys_.emplace_back(std::move(str));
 		KeyItemContext key_context{ *this };
 		return key_context;
 	}
 
 	Builder& Builder::Value(Node::Value val){
+		Node node;
+		*node = std::move(val);
+		InsertNode(std::move(node));
+
+		if (node_stack_.empty()) {
+			complite_container_ = true;
+		}
+		return *this;
+	}
+
+	Node& Builder::InsertNode(Node node) {
 		if (complite_container_) {
 			throw std::logic_error("Container already build");
 		}
 
-		Node node;
-		*node = val;
-
-		if (!node_stack_.empty()) {
-			if (node_stack_.back()->IsArray()) {
-				Array& ar = const_cast<Array&>(node_stack_.back()->AsArray());
-				ar.emplace_back(std::move(node));
-			}
-			else if (node_stack_.back()->IsDict()) {
-				Dict& dict = const_cast<Dict&>(node_stack_.back()->AsDict());
-				dict[keys_.back()] = std::move(node);
-				keys_.pop_back();
-			}
-		} else {
+		if (node_stack_.empty()) {
 			root_ = std::move(node);
-			complite_container_ = true;
+			return root_;
 		}
 
-		return *this;
+		Node& parent = *node_stack_.back();
+		if (parent.IsArray()) {
+			Array& ar = std::get<Array>(*parent);
+			return ar.emplace_back(std::move(node));
+		}
+
+		if (keys_.empty()) {
+			throw std::logic_error("Value in Dict container must follow a Key");
+		}
+		Dict& dict = std::get<Dict>(*parent);
+		auto it = dict.insert_or_assign(std::move(keys_.back()), std::move(node)).first;
+		keys_.pop_back();
+		return it->second;
 	}
 
 
@@ -64,15 +74,22 @@ namespace json {
 		return EndContainer<Dict>();
 	}
 
-	Node Builder::Build() {
+	Node Builder::Build() const & {
 		if (!complite_container_) {
 			throw std::logic_error("Container not ready");
 		}
 		return root_;
 	}
 
-	Builder::KeyItemContext Builder::BaseContext::Key(const std::string& str) {
-		return bld_.Key(str);
+	Node Builder::Build() && {
+		if (!complite_container_) {
+			throw std::logic_error("Container not ready");
+		}
+		return std::move(root_);
+	}
+
+	Builder::KeyItemContext Builder::BaseContext::Key(std::string str) {
+		return bld_.Key(std::move(str));
 	}
 
 	Builder::ArrayItemContext Builder::BaseContext::StartArray() {
@@ -93,8 +110,8 @@ namespace json {
 		return bld_;
 	}
 
-	Builder::KeyItemContext Builder::ValueKeyContext::Key(const std::string& str) {
-		return bld_.Key(str);
+	Builder::KeyItemContext Builder::ValueKeyContext::Key(std::string str) {
+		return bld_.Key(std::move(str));
 	}
 
 	Builder& Builder::ValueKeyContext::EndDict() {
@@ -102,13 +119,13 @@ namespace json {
 	}
 
 	Builder::ValueKeyContext Builder::KeyItemContext::Value(Node::Value val) {
-		bld_.Value(val);
+		bld_.Value(std::move(val));
 		ValueKeyContext value_context{ bld_ };
 		return value_context;
 	}
 
 	Builder::ArrayItemContext& Builder::ArrayItemContext::Value(Node::Value val) {
-		bld_.Value(val);
+		bld_.Value(std::move(val));
 		return *this;
 	}
 
@@ -9,7 +9,7 @@ namespace json {
 		class DictItemContext;
 	public:
 	
-		KeyItemContext Key(const std::string& str);
+		KeyItemContext Key(std::string str);
 		Builder& Value(Node::Value val);
 
 		ArrayItemContext StartArray();
@@ -18,14 +18,19 @@ namespace json {
 		Builder& EndArray();
 		Builder& EndDict();
 
-		Node Build();
+		Node Build() const &;
+		//hands the root out without copying, the builder can't be used after that
+		Node Build() &&;
 
 	private:
 		Node root_;
 		std::vector<std::string> keys_;
+		//open containers, pointing into root_
 		std::vector<Node*> node_stack_;
 		bool complite_container_ = false;
 
+		Node& InsertNode(Node node);
+
 		template <typename ItemContext, typename Container>
 		ItemContext StartContainer();
 
@@ -36,7 +41,7 @@ namespace json {
 		public:
 			BaseContext(Builder& bld) : bld_(bld) {}
 
-			KeyItemContext Key(const std::string& str);
+			KeyItemContext Key(std::string str);
 			DictItemContext StartDict();
 			ArrayItemContext StartArray();
 			Builder& EndDict();
@@ -50,7 +55,7 @@ namespace json {
 		public:
 			ValueKeyContext(Builder& bld) : bld_(bld) {}
 
-			KeyItemContext Key(const std::string& str);
+			KeyItemContext Key(std::string str);
 			Builder& EndDict();
 
 		private:
@@ -64,7 +69,7 @@ namespace json {
 
 			ValueKeyContext Value(Node::Value val);
 
-			KeyItemContext& Key(const std::string& str) = delete;
+			KeyItemContext& Key(std::string str) = delete;
 			Builder& EndDict() = delete;
 			Builder& EndArray() = delete;
 
@@ -78,7 +83,7 @@ namespace json {
 				: BaseContext(bld), bld_(bld) {}
 
 			ArrayItemContext& Value(Node::Value val);
-			KeyItemContext Key(const std::string& str) = delete;
+			KeyItemContext Key(std::string str) = delete;
 			Builder& EndDict() = delete;
 
 		private:
@@ -97,11 +102,8 @@ namespace json {
 
 	template <typename ItemContext, typename Container>
 	ItemContext Builder::StartContainer() {
-		if (complite_container_) {
-			throw std::logic_error("Container already build");
-		}
-		Container cont;
-		node_stack_.emplace_back(new Node{ cont });
+		Node& node = InsertNode(Container{});
+		node_stack_.emplace_back(&node);
 		ItemContext item_context{ *this };
 		return item_context;
 	}
@@ -111,30 +113,14 @@ namespace json {
 		if (complite_container_) {
 			throw std::logic_error("Container already build");
 		}
-		if (node_stack_.empty()) {
+		if (node_stack_.empty() || !std::holds_alternative<Container>(node_stack_.back()->GetValue())) {
 			throw std::logic_error("Container wrong ending");
 		}
 
-		Node* node = node_stack_.back();
 		node_stack_.pop_back();
-
-		if (!node_stack_.empty()) {
-			if (node_stack_.back()->IsArray()) {
-				Array& ar = const_cast<Array&>(node_stack_.back()->AsArray());
-				ar.emplace_back(*node);
-			}
-			else if (node_stack_.back()->IsDict()) {
-				Dict& dict = const_cast<Dict&>(node_stack_.back()->AsDict());
-				dict[keys_.back()] = *node;
-				keys_.pop_back();
-			}
-		}
-		else {
+		if (node_stack_.empty()) {
 			complite_container_ = true;
 		}
-
-		root_ = *node;
-		delete node;
 		return *this;
 	}
 
@@ -1,7 +1,127 @@
+#include <algorithm>
+#include <future>
+
 #include "json_reader.h"
+#include "key_table.h"
+#include "../util/metrics.h"
+
+namespace {
+    using namespace std::literals;
+
+    enum class RootKey { BaseRequests, RenderSettings, StatRequests, RoutingSettings };
+
+    constexpr json::KeyTable<RootKey, 4> ROOT_KEYS{ "request"sv, {{
+        {"base_requests"sv, RootKey::BaseRequests},
+        {"render_settings"sv, RootKey::RenderSettings},
+        {"stat_requests"sv, RootKey::StatRequests},
+        {"routing_settings"sv, RootKey::RoutingSettings},
+    }} };
+
+    enum class StopKey { Name, Latitude, Longitude, RoadDistances };
+
+    constexpr json::KeyTable<StopKey, 4> STOP_KEYS{ "Stop"sv, {{
+        {"name"sv, StopKey::Name, true},
+        {"latitude"sv, StopKey::Latitude, true},
+        {"longitude"sv, StopKey::Longitude, true},
+        {"road_distances"sv, StopKey::RoadDistances},
+    }} };
+
+    enum class BusKey { Name, IsRoundtrip, Stops };
+
+    constexpr json::KeyTable<BusKey, 3> BUS_KEYS{ "Bus"sv, {{
+        {"name"sv, BusKey::Name, true},
+        {"is_roundtrip"sv, BusKey::IsRoundtrip},
+        {"stops"sv, BusKey::Stops, true},
+    }} };
+
+    enum class StatKey { Id, Type, Name, From, To, Bbox, Zoom, Theme };
+
+    constexpr json::KeyTable<StatKey, 8> STAT_KEYS{ "stat_requests"sv, {{
+        {"id"sv, StatKey::Id, true},
+        {"type"sv, StatKey::Type, true},
+        {"name"sv, StatKey::Name},
+        {"from"sv, StatKey::From},
+        {"to"sv, StatKey::To},
+        {"bbox"sv, StatKey::Bbox},
+        {"zoom"sv, StatKey::Zoom},
+        {"theme"sv, StatKey::Theme},
+    }} };
+
+    const int MAX_ZOOM = 24;
+
+    enum class RenderKey {
+        Width, Height, Padding, StopRadius, LineWidth, BusLabelFontSize, BusLabelOffset,
+        StopLabelFontSize, StopLabelOffset, UnderlayerColor, UnderlayerWidth, ColorPalette,
+        SimplifyTolerance, SharedStyles, DecimalPlaces, Themes
+    };
+
+    constexpr json::KeyTable<RenderKey, 16> RENDER_KEYS{ "render_settings"sv, {{
+        {"width"sv, RenderKey::Width},
+        {"height"sv, RenderKey::Height},
+        {"padding"sv, RenderKey::Padding},
+        {"stop_radius"sv, RenderKey::StopRadius},
+        {"line_width"sv, RenderKey::LineWidth},
+        {"bus_label_font_size"sv, RenderKey::BusLabelFontSize},
+        {"bus_label_offset"sv, RenderKey::BusLabelOffset},
+        {"stop_label_font_size"sv, RenderKey::StopLabelFontSize},
+        {"stop_label_offset"sv, RenderKey::StopLabelOffset},
+        {"underlayer_color"sv, RenderKey::UnderlayerColor},
+        {"underlayer_width"sv, RenderKey::UnderlayerWidth},
+        {"color_palette"sv, RenderKey::ColorPalette},
+        {"simplify_tolerance"sv, RenderKey::SimplifyTolerance},
+        {"shared_styles"sv, RenderKey::SharedStyles},
+        {"decimal_places"sv, RenderKey::DecimalPlaces},
+        {"themes"sv, RenderKey::Themes},
+    }} };
+
+    enum class RoutingKey { BusWaitTime, BusVelocity, Router, RouterMemoryMb };
+
+    constexpr json::KeyTable<RoutingKey, 4> ROUTING_KEYS{ "routing_settings"sv, {{
+        {"bus_wait_time"sv, RoutingKey::BusWaitTime},
+        {"bus_velocity"sv, RoutingKey::BusVelocity},
+        {"router"sv, RoutingKey::Router},
+        {"router_memory_mb"sv, RoutingKey::RouterMemoryMb},
+    }} };
+
+    RouterStrategy ParseRouterStrategy(const std::string& name) {
+        for (RouterStrategy strategy : { RouterStrategy::Auto, RouterStrategy::AllPairs, RouterStrategy::PerQuery }) {
+            if (name == GetRouterStrategyName(strategy)) {
+                return strategy;
+            }
+        }
+        throw json::ParsingError("router must be auto, all_pairs or per_query in routing_settings");
+    }
+
+    svg::Point ParseOffset(const json::Node& node) {
+        return { node.AsArray().at(0).AsDouble(), node.AsArray().at(1).AsDouble() };
+    }
+
+    //bbox is [min_lat, min_lng, max_lat, max_lng]
+    renderer::Viewport ParseViewport(const json::Node& bbox, int zoom) {
+        if (!bbox.IsArray() || bbox.AsArray().size() != 4) {
+            throw json::ParsingError("bbox must be [min_lat, min_lng, max_lat, max_lng]");
+        }
+        const json::Array& corners = bbox.AsArray();
+        renderer::Viewport viewport;
+        viewport.min = { corners[0].AsDouble(), corners[1].AsDouble() };
+        viewport.max = { corners[2].AsDouble(), corners[3].AsDouble() };
+        if (viewport.min.lat > viewport.max.lat || viewport.min.lng > viewport.max.lng) {
+            throw json::ParsingError("empty bbox");
+        }
+        if (zoom < 0 || zoom > MAX_ZOOM) {
+            throw json::ParsingError("zoom must be in [0, " + std::to_string(MAX_ZOOM) + "]");
+        }
+        viewport.zoom = zoom;
+        return viewport;
+    }
+}
 
 void JSONReader::ReadJSON(std::istream& input){
-    json::Document parsed_node = json::Load(input);
+    std::optional<util::ScopedPhase> load_phase(std::in_place, "json_load");
+    //with a snapshot the base requests are not even built
+    json::Document parsed_node = read_base_requests_ ? json::Load(input)
+        : json::Load(input, { "base_requests"sv });
+    load_phase.reset();
     ParseJSON(parsed_node);
 }
 
@@ -10,29 +130,54 @@ void JSONReader::ParseJSON(const json::Document& doc) {
         throw json::ParsingError("wrong json");
     }
 
-    for (const auto& req : doc.GetRoot().AsDict()) {
-
-        if (req.first == "base_requests") {
-            ParseBaseRequests(req.second.AsArray());
-        }
-
-        if (req.first == "render_settings") {
-            ParseRenderSettings(req.second.AsDict());
+    //the catalogue is built on another thread while the settings and stat_requests
+    //are parsed here, the two stages don't share any state
+    const json::Node* base_requests = nullptr;
+    ROOT_KEYS.Dispatch(doc.GetRoot().AsDict(), [&](RootKey key, const json::Node& node) {
+        if (key == RootKey::BaseRequests && read_base_requests_) {
+            base_requests = &node;
         }
+    });
+    std::future<void> catalogue;
+    if (base_requests) {
+        catalogue = std::async(std::launch::async, [this, base_requests]() {
+            ParseBaseRequests(*base_requests);
+        });
+    }
 
-        if (req.first == "stat_requests") {
-            ParseStatRequests(req.second.AsArray());
-        }  
-
-        if(req.first == "routing_settings") {
-            ParseRoutingSettings(req.second.AsDict());
+    ROOT_KEYS.Dispatch(doc.GetRoot().AsDict(), [this](RootKey key, const json::Node& node) {
+        switch (key) {
+        case RootKey::BaseRequests:
+            break;
+        case RootKey::RenderSettings:
+            ParseRenderSettings(node);
+            break;
+        case RootKey::StatRequests:
+            ParseStatRequests(node);
+            break;
+        case RootKey::RoutingSettings:
+            ParseRoutingSettings(node);
+            break;
         }
+    });
+    //walking the whole document is paid only when a memory report may need it,
+    //measured while the catalogue may still be building
+    const bool memory_requested = std::any_of(req_list_.begin(), req_list_.end(), [](const RequestList& request) {
+        return request.type_ == RequestType::Memory;
+    });
+    if (measure_document_ || memory_requested) {
+        document_memory_ = json::GetMemoryUsage(doc.GetRoot());
+    }
+    if (catalogue.valid()) {
+        catalogue.get();
     }
 }
 
 void JSONReader::ParseBaseRequests(const json::Node& node) {
-    std::vector<json::Node> stops;
-    std::vector<json::Node> buses;
+    util::ScopedPhase phase("catalogue_build");
+    static const std::string type_key = "type";
+    std::vector<const json::Dict*> stops;
+    std::vector<const json::Dict*> buses;
     if (!node.IsArray()) {
         throw json::ParsingError("wrong json");
     }
@@ -42,56 +187,81 @@ void JSONReader::ParseBaseRequests(const json::Node& node) {
             throw json::ParsingError("wrong json");
         }
 
-        for (const auto& m : n.AsDict()) {
-            if (m.first == "type" && m.second.AsString() == "Stop") {
-                stops.emplace_back(n);
-            }
-            if (m.first == "type" && m.second.AsString() == "Bus") {
-                buses.emplace_back(n);
-            }
+        const auto type = n.AsDict().find(type_key);
+        if (type == n.AsDict().end()) {
+            throw json::ParsingError("missing key 'type' in base_requests");
+        }
+        if (type->second.AsString() == "Stop"sv) {
+            stops.emplace_back(&n.AsDict());
+        }
+        else if (type->second.AsString() == "Bus"sv) {
+            buses.emplace_back(&n.AsDict());
         }
     }
-   
+
     AddStopToCatalogue(stops);
-    stops.clear();
     AddBusToCatalogue(buses);
-    buses.clear();
 }
 
-transportcatalogue::TransportCatalogue JSONReader::GetTransportCatalague() const {
+const transportcatalogue::TransportCatalogue& JSONReader::GetTransportCatalague() const {
     return tc_;
 }
 
 
 void JSONReader::ParseStatRequests(const json::Node & node) {
-    RequestList rl;
     if (!node.IsArray()) {
         throw json::ParsingError("wrong stat_requests");
     }
 
+    req_list_.reserve(req_list_.size() + node.AsArray().size());
     for (const auto& request : node.AsArray()) {
-        if (!request.IsDict()) {
-            throw json::ParsingError("wrong stat_requests");
-        }
-        for (const auto& req : request.AsDict()) {
-            if (req.first == "id") {
-                rl.id_ = req.second.AsInt();
-            }
-            if (req.first == "type") {
-                rl.type_ = RequestHandler::GetRequestType(req.second.AsString());
-            }
-            if (req.first == "name") {
-                rl.name_ = req.second.AsString();
-            }   
-            if (req.first == "from") {
-                rl.from_ = req.second.AsString();
-            }
-            if (req.first == "to") {
-                rl.to_ = req.second.AsString();
-            }
+        req_list_.emplace_back(ParseStatRequest(request));
+    }
+}
+
+RequestList JSONReader::ParseStatRequest(const json::Node& request) {
+    RequestList rl;
+    if (!request.IsDict()) {
+        throw json::ParsingError("wrong stat_requests");
+    }
+    const json::Node* bbox = nullptr;
+    std::optional<int> zoom;
+    STAT_KEYS.Dispatch(request.AsDict(), [&](StatKey key, const json::Node& value) {
+        switch (key) {
+        case StatKey::Id:
+            rl.id_ = value.AsInt();
+            break;
+        case StatKey::Type:
+            rl.type_ = RequestHandler::GetRequestType(value.AsString());
+            break;
+        case StatKey::Name:
+            rl.name_ = value.AsString();
+            break;
+        case StatKey::From:
+            rl.from_ = value.AsString();
+            break;
+        case StatKey::To:
+            rl.to_ = value.AsString();
+            break;
+        case StatKey::Bbox:
+            bbox = &value;
+            break;
+        case StatKey::Zoom:
+            zoom = value.AsInt();
+            break;
+        case StatKey::Theme:
+            rl.theme_ = value.AsString();
+            break;
         }
-        req_list_.emplace_back(rl);
+    });
+
+    if (bbox) {
+        rl.viewport_ = ParseViewport(*bbox, zoom.value_or(0));
     }
+    else if (zoom) {
+        throw json::ParsingError("zoom requires bbox in stat_requests");
+    }
+    return rl;
 }
 
 std::vector<RequestList> JSONReader::GetRequestList() const {
@@ -120,52 +290,96 @@ svg::Color JSONReader::FindColor(const json::Node& node) const {
 }
 
 void JSONReader::ParseRenderSettings(const json::Node& node) {
-    using namespace std;
     if (!node.IsDict()) {
         throw json::ParsingError("wrong stat_requests");
     }
 
-    for (const auto& n : node.AsDict()) {
-        if (n.first == "width") {
-            rs_.width = n.second.AsDouble();
-        }
-        if (n.first == "height") {
-            rs_.height = n.second.AsDouble();
-        }
-        if (n.first == "padding") {
-            rs_.padding = n.second.AsDouble();
-        }
-        if (n.first == "stop_radius") {
-            rs_.stop_radius = n.second.AsDouble();
-        }
-        if (n.first == "line_width") {
-            rs_.line_width = n.second.AsDouble();
-        }
-        if (n.first == "bus_label_font_size") {
-            rs_.bus_label_font_size = n.second.AsInt();
-        }
-        if (n.first == "bus_label_offset") {
-            rs_.bus_label_offset.x = n.second.AsArray().at(0).AsDouble();
-            rs_.bus_label_offset.y = n.second.AsArray().at(1).AsDouble();
-        }
-        if (n.first == "stop_label_font_size") {
-            rs_.stop_label_font_size = n.second.AsInt();
-        }
-        if (n.first == "stop_label_offset") {
-            rs_.stop_label_offset.x = n.second.AsArray().at(0).AsDouble();
-            rs_.stop_label_offset.y = n.second.AsArray().at(1).AsDouble();
-        }
-        if (n.first == "underlayer_color") {
-            rs_.underlayer_color = FindColor(n.second);
-        }
-        if (n.first == "underlayer_width") {
-            rs_.underlayer_width = n.second.AsDouble();
+    //themes are applied on top of the base settings, so they are parsed after all other keys
+    const json::Node* themes = ApplyRenderSettings(node.AsDict(), rs_, false);
+    if (themes) {
+        ParseRenderThemes(*themes);
+    }
+}
+
+const json::Node* JSONReader::ApplyRenderSettings(const json::Dict& dict, RenderSettings& rs, bool is_theme) const {
+    const json::Node* themes = nullptr;
+    RENDER_KEYS.Dispatch(dict, [&](RenderKey key, const json::Node& value) {
+        //themes share the projected scene of the base map, so they can't change the canvas
+        if (is_theme && (key == RenderKey::Width || key == RenderKey::Height
+            || key == RenderKey::Padding || key == RenderKey::Themes)) {
+            throw json::ParsingError("themes can't set width, height, padding or themes");
         }
-        if (n.first == "color_palette") {
-            for (const auto& palette : n.second.AsArray()) {
-                rs_.color_palette.emplace_back(FindColor(palette));
+        switch (key) {
+        case RenderKey::Width:
+            rs.width = value.AsDouble();
+            break;
+        case RenderKey::Height:
+            rs.height = value.AsDouble();
+            break;
+        case RenderKey::Padding:
+            rs.padding = value.AsDouble();
+            break;
+        case RenderKey::StopRadius:
+            rs.stop_radius = value.AsDouble();
+            break;
+        case RenderKey::LineWidth:
+            rs.line_width = value.AsDouble();
+            break;
+        case RenderKey::BusLabelFontSize:
+            rs.bus_label_font_size = value.AsInt();
+            break;
+        case RenderKey::BusLabelOffset:
+            rs.bus_label_offset = ParseOffset(value);
+            break;
+        case RenderKey::StopLabelFontSize:
+            rs.stop_label_font_size = value.AsInt();
+            break;
+        case RenderKey::StopLabelOffset:
+            rs.stop_label_offset = ParseOffset(value);
+            break;
+        case RenderKey::UnderlayerColor:
+            rs.underlayer_color = FindColor(value);
+            break;
+        case RenderKey::UnderlayerWidth:
+            rs.underlayer_width = value.AsDouble();
+            break;
+        case RenderKey::ColorPalette:
+            rs.color_palette.clear();
+            for (const auto& palette : value.AsArray()) {
+                rs.color_palette.emplace_back(FindColor(palette));
+            }
+            break;
+        case RenderKey::SimplifyTolerance:
+            rs.simplify_tolerance = value.AsDouble();
+            break;
+        case RenderKey::SharedStyles:
+            rs.shared_styles = value.AsBool();
+            break;
+        case RenderKey::DecimalPlaces:
+            rs.decimal_places = value.AsInt();
+            if (rs.decimal_places < 0 || rs.decimal_places > svg::MAX_DECIMALS) {
+                throw json::ParsingError("decimal_places must be in [0, " + std::to_string(svg::MAX_DECIMALS) + "]");
             }
+            break;
+        case RenderKey::Themes:
+            themes = &value;
+            break;
+        }
+    });
+    return themes;
+}
+
+void JSONReader::ParseRenderThemes(const json::Node& node) {
+    if (!node.IsDict()) {
+        throw json::ParsingError("themes must be a dict");
+    }
+    for (const auto& [name, theme] : node.AsDict()) {
+        if (!theme.IsDict()) {
+            throw json::ParsingError("theme '" + name + "' must be a dict");
         }
+        RenderSettings rs = rs_;
+        ApplyRenderSettings(theme.AsDict(), rs, true);
+        themes_.emplace_back(name, std::move(rs));
     }
 }
 
@@ -173,107 +387,130 @@ RenderSettings JSONReader::GetRenderSettings() const {
     return rs_;
 }
 
+renderer::ThemeList JSONReader::GetRenderThemes() const {
+    return themes_;
+}
+
 void JSONReader::ParseRoutingSettings(const json::Node& node) {
     if (!node.IsDict()) {
         throw json::ParsingError("wrong json");
     }
 
-    for (const auto& setting : node.AsDict()) {
-        if (setting.first == "bus_wait_time") {
-            rstg_.bus_wait_time = setting.second.AsInt();
-        }
-        if (setting.first == "bus_velocity") {
-            rstg_.bus_velocity = setting.second.AsDouble();
+    ROUTING_KEYS.Dispatch(node.AsDict(), [this](RoutingKey key, const json::Node& value) {
+        switch (key) {
+        case RoutingKey::BusWaitTime:
+            rstg_.bus_wait_time = value.AsInt();
+            break;
+        case RoutingKey::BusVelocity:
+            rstg_.bus_velocity = value.AsDouble();
+            break;
+        case RoutingKey::Router:
+            rstg_.strategy = ParseRouterStrategy(value.AsString());
+            break;
+        case RoutingKey::RouterMemoryMb:
+            if (value.AsInt() < 0) {
+                throw json::ParsingError("router_memory_mb can't be negative in routing_settings");
+            }
+            rstg_.router_memory_mb = static_cast<size_t>(value.AsInt());
+            break;
         }
-    }
+    });
 }
 
 RouteSetting JSONReader::GetRoutSetting() const {
     return rstg_;
 }
 
-void JSONReader::AddStopToCatalogue(const std::vector<json::Node>& stops) {
-    std::string name;
-    std::vector<std::pair<std::string,int>> next_stop;
-    geo::Coordinates coords;
-    std::vector<transportcatalogue::DistanceBetStops> dbp;
-    std::vector<std::vector<transportcatalogue::DistanceBetStops>> distance_list;
-    
-    for (const auto& stop : stops) {
-        if (!stop.IsDict()) {
-            throw json::ParsingError("wrong json");
-        }
-            for (const auto& s : stop.AsDict()) {
-                if (s.first == "name") {
-                    name = s.second.AsString();
-                }
-                if (s.first == "latitude") {
-                    coords.lat = s.second.AsDouble();
-                }
-                if (s.first == "longitude") {
-                    coords.lng = s.second.AsDouble();
-                }
-                if (s.first == "road_distances") {
-                    if (s.second.IsDict()) {
-                        for (const auto& next : s.second.AsDict()) {
-                            next_stop.emplace_back(std::make_pair(next.first, next.second.AsInt()));
-                        }
-                    }
+std::optional<util::MemoryUsage> JSONReader::GetDocumentMemory() const {
+    return document_memory_;
+}
+
+void JSONReader::AddStopToCatalogue(const std::vector<const json::Dict*>& stops) {
+    //road distances may refer to stops described later, so they are added after all stops
+    std::vector<std::pair<const Stop*, const json::Dict*>> distance_list;
+    distance_list.reserve(stops.size());
+
+    for (const json::Dict* stop : stops) {
+        std::string name;
+        geo::Coordinates coords;
+        const json::Dict* road_distances = nullptr;
+
+        STOP_KEYS.Dispatch(*stop, [&](StopKey key, const json::Node& value) {
+            switch (key) {
+            case StopKey::Name:
+                name = value.AsString();
+                break;
+            case StopKey::Latitude:
+                coords.lat = value.AsDouble();
+                break;
+            case StopKey::Longitude:
+                coords.lng = value.AsDouble();
+                break;
+            case StopKey::RoadDistances:
+                if (value.IsDict()) {
+                    road_distances = &value.AsDict();
                 }
+                break;
             }
-        
-        for (const auto& a : next_stop) {
-            dbp.emplace_back(transportcatalogue::DistanceBetStops( name, a.first, a.second ));
-        }
-        distance_list.emplace_back(dbp);
-        tc_.AddStop(name, coords);
+        });
 
-        next_stop.clear();
-        dbp.clear();
+        tc_.AddStop(std::move(name), coords);
+        if (road_distances) {
+            distance_list.emplace_back(&tc_.GetStops().back(), road_distances);
+        }
     }
-    
-    for (const auto& list : distance_list) {
-        tc_.FillDistanceList(list);
+
+    for (const auto& [from, distances] : distance_list) {
+        for (const auto& [to_name, distance] : *distances) {
+            const Stop* to = tc_.GetStop(to_name);
+            if (!to) {
+                throw json::ParsingError("unknown stop '" + to_name + "' in road_distances");
+            }
+            if (distance.AsInt() != 0) {
+                tc_.SetDistance(from, to, distance.AsInt());
+            }
+        }
     }
-    distance_list.clear();
 }
 
-void JSONReader::AddBusToCatalogue(const std::vector<json::Node>& buses) {
-    std::string name;
-    bool is_roundtrip = false;
-    std::vector<std::string_view> stops;
-    std::vector<std::string_view> route;
+void JSONReader::AddBusToCatalogue(const std::vector<const json::Dict*>& buses) {
+    std::vector<const Stop*> route;
 
-    for (const auto& bus : buses) {
-        if (!bus.IsDict()) {
-            throw json::ParsingError("wrong json");
-        }
-        for (const auto& bu : bus.AsDict()) {
-            if (bu.first == "name") {
-                name = bu.second.AsString();
-            }
-            if (bu.first == "is_roundtrip") {
-                is_roundtrip = bu.second.AsBool();
-            }
-            if (bu.first == "stops") {
-                if (!bu.second.IsArray()) {
+    for (const json::Dict* bus : buses) {
+        std::string name;
+        bool is_roundtrip = false;
+        route.clear();
+
+        BUS_KEYS.Dispatch(*bus, [&](BusKey key, const json::Node& value) {
+            switch (key) {
+            case BusKey::Name:
+                name = value.AsString();
+                break;
+            case BusKey::IsRoundtrip:
+                is_roundtrip = value.AsBool();
+                break;
+            case BusKey::Stops:
+                if (!value.IsArray()) {
                     throw json::ParsingError("wrong json");
                 }
-                for (const auto& b : bu.second.AsArray()) {  
-                        stops.emplace_back(b.AsString());
+                route.reserve(value.AsArray().size() * 2);
+                for (const auto& b : value.AsArray()) {
+                    const Stop* stop = tc_.GetStop(b.AsString());
+                    if (!stop) {
+                        throw json::ParsingError("unknown stop '" + b.AsString() + "' in Bus");
+                    }
+                    route.emplace_back(stop);
                 }
+                break;
             }
-        }
+        });
 
-        route = stops;
-        if (!is_roundtrip) {
-            for (size_t i = stops.size() - 1; i != 0; --i) {
-                route.emplace_back(stops[i - 1]);
+        if (!is_roundtrip && !route.empty()) {
+            for (size_t i = route.size() - 1; i != 0; --i) {
+                route.emplace_back(route[i - 1]);
             }
         }
-    
+
         tc_.AddBus(name, is_roundtrip, route);
-        route.clear();
-        stops.clear();
     }
 }
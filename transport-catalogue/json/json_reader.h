@@ -1,4 +1,5 @@
 #pragma once
+#include <optional>
 #include <sstream>
 #include "json.h"
 #include "../img/map_renderer.h"
@@ -8,29 +9,53 @@
 
 class JSONReader {
 public:
-	JSONReader(std::istream& input) {
+	//base_requests are skipped when the catalogue comes from a snapshot;
+	//the document is measured if measure_document is set or stat_requests ask for Memory
+	JSONReader(std::istream& input, bool read_base_requests = true, bool measure_document = false)
+		: read_base_requests_(read_base_requests), measure_document_(measure_document) {
 		ReadJSON(input);
 	}
 
-	transportcatalogue::TransportCatalogue GetTransportCatalague() const;
+	//takes an already loaded document
+	JSONReader(const json::Document& doc, bool read_base_requests = true, bool measure_document = false)
+		: read_base_requests_(read_base_requests), measure_document_(measure_document) {
+		ParseJSON(doc);
+	}
+
+	const transportcatalogue::TransportCatalogue& GetTransportCatalague() const;
 	std::vector<RequestList> GetRequestList() const;
 	RenderSettings GetRenderSettings() const;
+	//named variants of the render settings, sorted by name
+	renderer::ThemeList GetRenderThemes() const;
 	RouteSetting GetRoutSetting() const;
+	//heap memory the parsed document held, it is freed once the reader is built;
+	//empty if the document was not measured
+	std::optional<util::MemoryUsage> GetDocumentMemory() const;
+
+	//parse one element of stat_requests
+	static RequestList ParseStatRequest(const json::Node& request);
 	
 private:
 	transportcatalogue::TransportCatalogue tc_;
 	std::vector<RequestList> req_list_;
 	RenderSettings rs_;
+	renderer::ThemeList themes_;
 	RouteSetting rstg_;
+	bool read_base_requests_ = true;
+	bool measure_document_ = false;
+	std::optional<util::MemoryUsage> document_memory_;
 
 	void ReadJSON(std::istream& input);
 	void ParseJSON(const json::Document& doc);
 	void ParseBaseRequests(const json::Node& node);
 	svg::Color FindColor(const json::Node& node) const;
 	void ParseRenderSettings(const json::Node& node);
+	//applies the keys of the dict to rs and returns the themes node if there is one
+	const json::Node* ApplyRenderSettings(const json::Dict& dict, RenderSettings& rs, bool is_theme) const;
+	void ParseRenderThemes(const json::Node& node);
 	void ParseStatRequests(const json::Node& node);
 	void ParseRoutingSettings(const json::Node& node);
-	void AddStopToCatalogue(const std::vector<json::Node>& stops);
-	void AddBusToCatalogue(const std::vector<json::Node>& buses);
+	void AddStopToCatalogue(const std::vector<const json::Dict*>& stops);
+	void AddBusToCatalogue(const std::vector<const json::Dict*>& buses);
 	
 };
@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "json.h"
+
+namespace json {
+
+// Compile-time table of the keys a dict may hold. A key is found with a perfect hash
+// of its length and first, middle and last characters; the hash seed is picked by
+// the compiler, so a table that can't be hashed without collisions does not compile
+template <typename Field, size_t N>
+class KeyTable {
+public:
+    struct Entry {
+        std::string_view key;
+        Field field;
+        bool required = false;
+    };
+
+    constexpr KeyTable(std::string_view name, const std::array<Entry, N>& entries)
+        : name_(name), entries_(entries) {
+        static_assert(N <= 64, "KeyTable holds at most 64 keys");
+        for (size_t i = 0; i != N; ++i) {
+            if (entries_[i].required) {
+                required_ |= uint64_t{1} << i;
+            }
+        }
+        for (seed_ = 1; seed_ != MAX_SEED; ++seed_) {
+            if (TryFillSlots()) {
+                return;
+            }
+        }
+        throw std::logic_error("no perfect hash for the key table");
+    }
+
+    // Calls handler(field, node) for every known key of the dict in a single pass,
+    // unknown keys are skipped. Throws ParsingError if a required key is missing
+    template <typename Handler>
+    void Dispatch(const Dict& dict, Handler&& handler) const {
+        uint64_t seen = 0;
+        for (const auto& [key, node] : dict) {
+            const int index = FindIndex(key);
+            if (index < 0) {
+                continue;
+            }
+            seen |= uint64_t{1} << index;
+            handler(entries_[index].field, node);
+        }
+        if ((seen & required_) != required_) {
+            ThrowMissing(seen);
+        }
+    }
+
+    constexpr int FindIndex(std::string_view key) const {
+        if (key.empty()) {
+            return -1;
+        }
+        const int index = slots_[Hash(key, seed_)];
+        return index >= 0 && entries_[index].key == key ? index : -1;
+    }
+
+private:
+    static constexpr size_t MAX_SEED = 4096;
+    // power of two with at least four slots per key
+    static constexpr size_t SLOT_COUNT = [] {
+        size_t count = 8;
+        while (count < N * 4) {
+            count *= 2;
+        }
+        return count;
+    }();
+
+    std::string_view name_;
+    std::array<Entry, N> entries_;
+    std::array<int, SLOT_COUNT> slots_{};
+    uint64_t required_ = 0;
+    size_t seed_ = 0;
+
+    static constexpr size_t Hash(std::string_view key, size_t seed) {
+        const size_t h = key.size() * (seed * 2 + 1)
+            + static_cast<unsigned char>(key.front()) * (seed * 7 + 3)
+            + static_cast<unsigned char>(key[key.size() / 2]) * (seed * 13 + 5)
+            + static_cast<unsigned char>(key.back());
+        return (h ^ (h >> 7)) & (SLOT_COUNT - 1);
+    }
+
+    constexpr bool TryFillSlots() {
+        for (auto& slot : slots_) {
+            slot = -1;
+        }
+        for (size_t i = 0; i != N; ++i) {
+            auto& slot = slots_[Hash(entries_[i].key, seed_)];
+            if (slot >= 0) {
+                return false;
+            }
+            slot = static_cast<int>(i);
+        }
+        return true;
+    }
+
+    [[noreturn]] void ThrowMissing(uint64_t seen) const {
+        using namespace std::literals;
+        for (size_t i = 0; i != N; ++i) {
+            if (entries_[i].required && !(seen & (uint64_t{1} << i))) {
+                throw ParsingError("missing key '"s + std::string(entries_[i].key) + "' in "s + std::string(name_));
+            }
+        }
+        throw ParsingError("missing key in "s + std::string(name_));
+    }
+};
+
+}  // namespace json
@@ -1,27 +1,263 @@
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 
+#include "../data/catalogue_snapshot.h"
 #include "../json/json_reader.h"
 #include "../img/map_renderer.h"
 #include "request_handler.h"
+#include "socket_server.h"
+#include "../util/metrics.h"
 
 
 using namespace std;
 
 using namespace transportcatalogue;
 
+namespace {
 
-int main() {
+    struct LaunchOptions {
+        //answer newline-delimited stat requests after the base document
+        bool ndjson = false;
+        //read the base document from this file instead of stdin
+        string base_file;
+        //take the catalogue from a binary snapshot, base_requests are ignored
+        string snapshot_file;
+        //write the catalogue built from base_requests to a binary snapshot and exit
+        string save_snapshot_file;
+        //print the share of repeated stat requests to stderr
+        bool duplicate_stats = false;
+        //serve stat requests on this Unix domain socket instead of answering stdin
+        string serve_path;
+        //connections served at the same time in the serve mode, 0 for one per core
+        size_t workers = 0;
+        //report phase times and request latencies when the run ends
+        bool metrics = false;
+        //the report goes to this file, to stderr if it is empty
+        string metrics_file;
+        //report the heap memory of each subsystem when the requests are answered
+        bool memory = false;
+        //the report goes to this file, to stderr if it is empty
+        string memory_file;
+    };
 
-    JSONReader reader(cin);
-    const TransportCatalogue catalogue = reader.GetTransportCatalague();
+    SocketServer* running_server = nullptr;
+
+    void StopServer(int) {
+        if (running_server) {
+            running_server->Stop();
+        }
+    }
+
+    LaunchOptions ParseLaunchOptions(int argc, char* argv[]) {
+        LaunchOptions options;
+        for (int i = 1; i < argc; ++i) {
+            const string_view arg = argv[i];
+            if (arg == "--ndjson"sv) {
+                options.ndjson = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    options.base_file = argv[++i];
+                }
+            }
+            else if (arg == "--serve"sv && i + 1 < argc) {
+                options.serve_path = argv[++i];
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    options.base_file = argv[++i];
+                }
+            }
+            else if (arg == "--metrics"sv) {
+                options.metrics = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    options.metrics_file = argv[++i];
+                }
+            }
+            else if (arg == "--memory"sv) {
+                options.memory = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    options.memory_file = argv[++i];
+                }
+            }
+            else if (arg == "--workers"sv && i + 1 < argc) {
+                options.workers = strtoull(argv[++i], nullptr, 10);
+            }
+            else if (arg == "--duplicate-stats"sv) {
+                options.duplicate_stats = true;
+            }
+            else if ((arg == "--snapshot"sv || arg == "--save-snapshot"sv) && i + 1 < argc) {
+                (arg == "--snapshot"sv ? options.snapshot_file : options.save_snapshot_file) = argv[++i];
+            }
+            else {
+                throw invalid_argument("unknown option "s + argv[i]);
+            }
+        }
+        return options;
+    }
+
+    double ToMilliseconds(chrono::nanoseconds duration) {
+        return chrono::duration<double, milli>(duration).count();
+    }
+
+    void PrintMetrics(chrono::nanoseconds total, ostream& out) {
+        const util::Metrics& metrics = util::Metrics::Get();
+        json::Dict phases;
+        for (const auto& phase : metrics.GetPhases()) {
+            phases.emplace(phase.name, json::Dict{
+                { "count"s, static_cast<int>(phase.count) },
+                { "ms"s, ToMilliseconds(phase.total) },
+            });
+        }
+        json::Dict requests;
+        for (const auto& [name, histogram] : metrics.GetHistograms()) {
+            requests.emplace(name, json::Dict{
+                { "count"s, static_cast<int>(histogram->GetCount()) },
+                { "p50_us"s, ToMilliseconds(histogram->GetPercentile(0.5)) * 1000 },
+                { "p99_us"s, ToMilliseconds(histogram->GetPercentile(0.99)) * 1000 },
+                { "max_us"s, ToMilliseconds(histogram->GetMax()) * 1000 },
+            });
+        }
+        json::Dict notes;
+        for (auto& [name, text] : metrics.GetNotes()) {
+            notes.emplace(move(name), move(text));
+        }
+        json::Print(json::Document{ json::Dict{
+            { "total_ms"s, ToMilliseconds(total) },
+            { "phases"s, move(phases) },
+            { "requests"s, move(requests) },
+            { "notes"s, move(notes) },
+        } }, out);
+        out << endl;
+    }
+
+    //to stderr when the file name is empty
+    template <typename Print>
+    void WriteReport(const string& file, Print print) {
+        if (file.empty()) {
+            print(cerr);
+        }
+        else {
+            ofstream out(file);
+            print(out);
+        }
+    }
+
+    void PrintUsage(ostream& out) {
+        out << "Usage: transport_catalog [--ndjson [base.json] | --serve socket [base.json] [--workers n]] [--snapshot file | --save-snapshot file] [--duplicate-stats] [--metrics [file]] [--memory [file]]"sv << endl;
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+    LaunchOptions options;
+    try {
+        options = ParseLaunchOptions(argc, argv);
+    }
+    catch (const invalid_argument& e) {
+        cerr << e.what() << endl;
+        PrintUsage(cerr);
+        return 1;
+    }
+
+    const auto start = chrono::steady_clock::now();
+    if (options.metrics) {
+        util::Metrics::Get().Enable();
+    }
+
+    ifstream base_file;
+    if (!options.base_file.empty()) {
+        base_file.open(options.base_file);
+        if (!base_file) {
+            cerr << "can't open "sv << options.base_file << endl;
+            return 1;
+        }
+    }
+
+    //with --memory the input document is measured too, otherwise only when stat_requests ask for Memory
+    JSONReader reader(options.base_file.empty() ? static_cast<istream&>(cin) : base_file, options.snapshot_file.empty(), options.memory);
+
+    if (!options.save_snapshot_file.empty()) {
+        ofstream out(options.save_snapshot_file, ios::binary);
+        try {
+            SaveSnapshot(reader.GetTransportCatalague(), out);
+        }
+        catch (const SnapshotError& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    optional<TransportCatalogue> snapshot_catalogue;
+    if (!options.snapshot_file.empty()) {
+        try {
+            util::ScopedPhase phase("snapshot_load");
+            snapshot_catalogue = LoadSnapshot(CatalogueSnapshot(options.snapshot_file));
+        }
+        catch (const SnapshotError& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+    const TransportCatalogue& catalogue = snapshot_catalogue ? *snapshot_catalogue : reader.GetTransportCatalague();
 
     const RenderSettings rs = reader.GetRenderSettings();
     const RouteSetting rstg = reader.GetRoutSetting();
 
-    const renderer::MapRenderer mr(rs);
+    //the handler waits for its background builds when it goes out of scope,
+    //so the metrics are reported after they are over
+    {
+        RequestHandler rq(catalogue, reader.GetRequestList(), rs, reader.GetRenderThemes(), rstg);
+        rq.SetDocumentMemory(reader.GetDocumentMemory());
+        if (options.duplicate_stats) {
+            rq.SetDuplicateReport(&cerr);
+        }
+        //a line once per run, when the router is first needed
+        rq.SetRouterLog(&cerr);
+        if (!options.serve_path.empty()) {
+            ServerOptions server_options;
+            server_options.path = options.serve_path;
+            if (options.workers) {
+                server_options.workers = options.workers;
+            }
+            //clients may ask anything, so everything is prepared while the socket opens
+            rq.StartWarmUp(true, true);
+            SocketServer server(rq, server_options);
+            running_server = &server;
+            signal(SIGINT, StopServer);
+            signal(SIGTERM, StopServer);
+            try {
+                server.Run();
+            }
+            catch (const ServerError& e) {
+                cerr << e.what() << endl;
+                return 1;
+            }
+            running_server = nullptr;
+        }
+        else if (options.ndjson) {
+            rq.StartWarmUp(true, true);
+            rq.AnswerOnStream(cin, cout);
+        }
+        else {
+            rq.AnswerOnRequests();
+        }
 
-    const RequestHandler rq(catalogue, reader.GetRequestList(), mr, rstg);
-    rq.AnswerOnRequests();
+        //the answers have waited for whatever they needed, a build still running is not counted
+        if (options.memory) {
+            WriteReport(options.memory_file, [&rq](ostream& out) {
+                json::Print(json::Document{ rq.GetMemoryReport() }, out);
+                out << endl;
+            });
+        }
+    }
 
-}
\ No newline at end of file
+    if (options.metrics) {
+        const auto total = chrono::steady_clock::now() - start;
+        WriteReport(options.metrics_file, [total](ostream& out) {
+            PrintMetrics(total, out);
+        });
+    }
+}
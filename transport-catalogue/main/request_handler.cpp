@@ -1,33 +1,395 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include <variant>
+
 #include "request_handler.h"
+#include "../json/json_reader.h"
+#include "../util/metrics.h"
+#include "../util/thread_pool.h"
+
+namespace {
+    //requests answered by one task of the pool
+    const size_t ANSWER_BLOCK_SIZE = 256;
+    //blocks per pool thread kept in memory before they are written out
+    const size_t BLOCKS_PER_THREAD = 8;
+
+    const size_t NO_SHARED_ANSWER = std::numeric_limits<size_t>::max();
+    const RequestType QUERY_TYPES[] = { RequestType::Bus, RequestType::Stop, RequestType::Map, RequestType::Route, RequestType::Memory };
+    //RequestType values of QUERY_TYPES are below this
+    const size_t QUERY_TYPE_COUNT = static_cast<size_t>(RequestType::Non);
+
+    //the answer depends only on the request and the catalogue; a Memory report changes
+    //as the router and the maps get built, so it is never shared
+    bool IsPureQuery(RequestType type) {
+        return type != RequestType::Non && type != RequestType::Memory;
+    }
+
+    //everything the answer depends on except the id
+    std::string MakeQueryKey(const RequestList& request) {
+        std::string key(1, static_cast<char>(request.type_));
+        auto add = [&key](std::string_view field) {
+            key += field;
+            key += '\0';
+        };
+        switch (request.type_) {
+        case RequestType::Bus:
+        case RequestType::Stop:
+            add(request.name_);
+            break;
+        case RequestType::Route:
+            add(request.from_);
+            add(request.to_);
+            break;
+        case RequestType::Map:
+            add(request.theme_);
+            if (request.viewport_) {
+                const renderer::Viewport& view = *request.viewport_;
+                for (double value : { view.min.lat, view.min.lng, view.max.lat, view.max.lng }) {
+                    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+                }
+                key.append(reinterpret_cast<const char*>(&view.zoom), sizeof(view.zoom));
+            }
+            break;
+        default:
+            break;
+        }
+        return key;
+    }
+
+    //answer of a query asked more than once, printed by the first request that needs it;
+    //the others copy the text and put their own id in place of the first one's
+    struct SharedAnswer {
+        std::once_flag printed;
+        std::string text;
+        size_t id_begin = 0;
+        size_t id_end = 0;
+        //requests still to copy the text, it is freed after the last one
+        std::atomic<size_t> remaining{ 0 };
+    };
+
+    //answers of a block in order: runs of answers printed on the pool, and Map answers,
+    //which are written from the renderer's cached body instead of being copied into a buffer
+    using AnswerBlock = std::vector<std::variant<std::string, json::Node>>;
+
+    struct QueryStats {
+        size_t requests = 0;
+        size_t distinct = 0;
+    };
+
+    //shared_index[i] is the SharedAnswer of request i, or NO_SHARED_ANSWER for a query asked once
+    //or a map; returns the number of requests of each shared answer
+    std::vector<size_t> GroupQueries(const std::vector<RequestList>& rl, std::vector<size_t>& shared_index,
+        std::unordered_map<RequestType, QueryStats>& stats) {
+        std::unordered_map<std::string, size_t> queries;
+        std::vector<size_t> counts;
+        shared_index.assign(rl.size(), NO_SHARED_ANSWER);
+        for (size_t i = 0; i != rl.size(); ++i) {
+            if (!IsPureQuery(rl[i].type_)) {
+                continue;
+            }
+            QueryStats& type_stats = stats[rl[i].type_];
+            ++type_stats.requests;
+            const auto [it, inserted] = queries.emplace(MakeQueryKey(rl[i]), counts.size());
+            if (inserted) {
+                ++type_stats.distinct;
+                counts.push_back(0);
+            }
+            //a repeated map already shares the renderer's cached body, printing it once more
+            //to put in the ids would only copy it
+            if (rl[i].type_ != RequestType::Map) {
+                ++counts[it->second];
+                shared_index[i] = it->second;
+            }
+        }
+
+        std::vector<size_t> shared_counts;
+        std::vector<size_t> query_to_shared(counts.size(), NO_SHARED_ANSWER);
+        for (size_t query = 0; query != counts.size(); ++query) {
+            if (counts[query] > 1) {
+                query_to_shared[query] = shared_counts.size();
+                shared_counts.push_back(counts[query]);
+            }
+        }
+        for (size_t& index : shared_index) {
+            if (index != NO_SHARED_ANSWER) {
+                index = query_to_shared[index];
+            }
+        }
+        return shared_counts;
+    }
+}
 
-void RequestHandler::AnswerOnRequests() const {
-    Print(RequestToHandler(rq_),std::cout);
+void RequestHandler::AnswerOnRequests(std::ostream& out) const {
+    //set before the router may start building
+    route_queries_ = std::count_if(rq_.begin(), rq_.end(), [](const RequestList& request) {
+        return request.type_ == RequestType::Route; });
+    const bool has_route = route_queries_ != 0;
+    //viewports are cut out of the scene on demand, only the whole map is worth drawing ahead
+    const bool has_map = std::any_of(rq_.begin(), rq_.end(), [](const RequestList& request) {
+        return request.type_ == RequestType::Map && !request.viewport_; });
+    StartWarmUp(has_route, has_map);
+    RequestToHandler(rq_, out);
+}
+
+void RequestHandler::StartWarmUp(bool router, bool map) const {
+    if (router) {
+        warm_ups_.push_back(std::async(std::launch::async, [this]() {
+            GetRouter();
+        }));
+    }
+    if (map) {
+        warm_ups_.push_back(std::async(std::launch::async, [this]() {
+            GetRenderedMap(0);
+        }));
+    }
 }
 
-json::Document RequestHandler::RequestToHandler(const std::vector<RequestList>& rl) const {
-    json::Array result;
-    
-    for (const auto& request : rl) {
-        if (request.type_ == RequestType::Bus) {
-            auto answer = GetBusStat(request.name_);
-            if (answer != std::nullopt) {              
-                result.emplace_back(CreateBusRequest(request.id_, answer.value()));
+void RequestHandler::SetDuplicateReport(std::ostream* out) {
+    duplicate_report_ = out;
+}
+
+void RequestHandler::SetRouterLog(std::ostream* out) {
+    router_log_ = out;
+}
+
+void RequestHandler::SetDocumentMemory(std::optional<util::MemoryUsage> usage) {
+    document_memory_ = usage;
+}
+
+json::Dict RequestHandler::GetMemoryReport() const {
+    using namespace std::literals;
+    json::Dict report;
+    util::MemoryUsage total;
+    auto add = [&report, &total](std::string name, const util::MemoryUsage& usage) {
+        total += usage;
+        //KiB rather than bytes, the sizes of a big city don't fit into an int
+        report.emplace(std::move(name), json::Dict{
+            { "kib"s, static_cast<int>((usage.bytes + 1023) / 1024) },
+            { "allocations"s, static_cast<int>(usage.allocations) },
+        });
+    };
+    //the reader measures the document only when a report was asked for in advance
+    if (document_memory_) {
+        add("json_document"s, *document_memory_);
+    }
+    add("catalogue"s, tc_.GetMemoryUsage());
+    util::MemoryUsage graph, table, metadata;
+    if (router_built_.load(std::memory_order_acquire)) {
+        graph = router_->GetGraphMemory();
+        table = router_->GetTableMemory();
+        metadata = router_->GetMetadataMemory();
+    }
+    add("route_graph"s, graph);
+    add("router_table"s, table);
+    add("router_metadata"s, metadata);
+    util::MemoryUsage scene, maps;
+    if (scene_built_.load(std::memory_order_acquire)) {
+        scene = scene_.GetMemoryUsage();
+    }
+    if (renderer_built_.load(std::memory_order_acquire)) {
+        maps.AddDeque(map_cache_);
+        for (const CachedMap& cached : map_cache_) {
+            if (cached.ready.load(std::memory_order_acquire)) {
+                maps += cached.map.GetMemoryUsage();
             }
-            else {
-                result.emplace_back(CreateErrorMessage(request.id_));
-            }      
         }
-        if (request.type_ == RequestType::Stop) {
-            result.emplace_back(CreateStopRequest(request.id_, GetBusesByStop(request.name_)));
+    }
+    add("map_scene"s, scene);
+    add("map_output"s, maps);
+    const util::MemoryUsage all = total;
+    add("total"s, all);
+    return report;
+}
+
+void RequestHandler::RequestToHandler(const std::vector<RequestList>& rl, std::ostream& out) const {
+    util::ScopedPhase answer_phase("answer");
+    json::ArrayWriter writer(out);
+    util::ThreadPool& pool = util::GetSharedPool();
+
+    //latency of every request is recorded only when the metrics are on
+    std::array<util::LatencyHistogram*, QUERY_TYPE_COUNT> histograms{};
+    const bool timed = util::Metrics::Get().IsEnabled();
+    if (timed) {
+        for (RequestType type : QUERY_TYPES) {
+            histograms[static_cast<size_t>(type)] = &util::Metrics::Get().GetHistogram(GetRequestTypeName(type));
         }
-        if (request.type_ == RequestType::Map) {
-            result.emplace_back(CreateMap(request.id_));
+    }
+
+    //identical queries are answered once, whatever their ids
+    std::vector<size_t> shared_index;
+    std::unordered_map<RequestType, QueryStats> stats;
+    const std::vector<size_t> shared_counts = GroupQueries(rl, shared_index, stats);
+    std::vector<SharedAnswer> shared_answers(shared_counts.size());
+    for (size_t i = 0; i != shared_counts.size(); ++i) {
+        shared_answers[i].remaining = shared_counts[i];
+    }
+
+    //blocks of requests are answered and printed in parallel, each into its own buffer,
+    //except the maps; a window of blocks is written out in order before the next window starts. The first
+    //window is a single block and the windows grow from there, so the first answers
+    //go out while the router or the map may still be building
+    const size_t max_window = ANSWER_BLOCK_SIZE * BLOCKS_PER_THREAD * (pool.GetThreadCount() + 1);
+    size_t window = ANSWER_BLOCK_SIZE;
+    std::vector<AnswerBlock> blocks;
+    for (size_t start = 0; start < rl.size(); start += window, window = std::min(window * 2, max_window)) {
+        const size_t end = std::min(rl.size(), start + window);
+        blocks.assign((end - start + ANSWER_BLOCK_SIZE - 1) / ANSWER_BLOCK_SIZE, AnswerBlock());
+        pool.ParallelFor(blocks.size(), [&](size_t block) {
+            const size_t first = start + block * ANSWER_BLOCK_SIZE;
+            const size_t last = std::min(end, first + ANSWER_BLOCK_SIZE);
+            AnswerBlock& parts = blocks[block];
+            std::ostringstream printed;
+            bool empty = true;
+            auto end_printed = [&]() {
+                if (!empty) {
+                    parts.emplace_back(printed.str());
+                    printed.str(std::string());
+                    empty = true;
+                }
+            };
+            for (size_t i = first; i != last; ++i) {
+                const auto begin = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                if (shared_index[i] != NO_SHARED_ANSWER) {
+                    SharedAnswer& shared = shared_answers[shared_index[i]];
+                    std::call_once(shared.printed, [&]() {
+                        PrintSharedAnswer(rl[i], shared.text, shared.id_begin, shared.id_end);
+                    });
+                    if (!shared.text.empty()) {
+                        if (!empty) {
+                            printed << ",\n";
+                        }
+                        empty = false;
+                        const std::string_view text = shared.text;
+                        printed << text.substr(0, shared.id_begin) << rl[i].id_ << text.substr(shared.id_end);
+                    }
+                    if (--shared.remaining == 0) {
+                        std::string().swap(shared.text);
+                    }
+                }
+                else if (auto answer = AnswerOnRequest(rl[i]); answer && rl[i].type_ == RequestType::Map) {
+                    end_printed();
+                    parts.emplace_back(std::move(*answer));
+                }
+                else if (answer) {
+                    if (!empty) {
+                        printed << ",\n";
+                    }
+                    empty = false;
+                    json::ArrayWriter::PrintElement(*answer, printed);
+                }
+                if (timed && rl[i].type_ != RequestType::Non) {
+                    histograms[static_cast<size_t>(rl[i].type_)]->Record(std::chrono::steady_clock::now() - begin);
+                }
+            }
+            end_printed();
+        });
+        util::ScopedPhase output_phase("output");
+        for (const AnswerBlock& parts : blocks) {
+            for (const auto& part : parts) {
+                if (const auto* text = std::get_if<std::string>(&part)) {
+                    writer.AddPrinted(*text);
+                }
+                else {
+                    writer.Add(std::get<json::Node>(part));
+                }
+            }
         }
-        if (request.type_ == RequestType::Route) {
-            result.emplace_back(CreateRoute(request.id_, request.from_, request.to_));
+        out.flush();
+    }
+    writer.Finish();
+
+    if (duplicate_report_) {
+        for (RequestType type : QUERY_TYPES) {
+            if (!IsPureQuery(type)) {
+                continue;
+            }
+            const QueryStats& type_stats = stats[type];
+            const double hit_ratio = type_stats.requests
+                ? static_cast<double>(type_stats.requests - type_stats.distinct) / type_stats.requests : 0;
+            *duplicate_report_ << "duplicates " << GetRequestTypeName(type) << ": requests=" << type_stats.requests
+                << " distinct=" << type_stats.distinct << " hit_ratio=" << hit_ratio << std::endl;
         }
     }
-    return json::Document{ result };
+}
+
+void RequestHandler::PrintSharedAnswer(const RequestList& request, std::string& text, size_t& id_begin, size_t& id_end) const {
+    using namespace std::literals;
+    const auto answer = AnswerOnRequest(request);
+    if (!answer) {
+        return;
+    }
+    std::ostringstream printed;
+    json::ArrayWriter::PrintElement(*answer, printed);
+    text = printed.str();
+    //strings are escaped, so the only unescaped key in the text is the answer's own request_id
+    const std::string_view key = "\"request_id\": "sv;
+    id_begin = text.find(key) + key.size();
+    id_end = text.find_first_not_of("-0123456789"sv, id_begin);
+}
+
+void RequestHandler::AnswerOnStream(std::istream& input, std::ostream& out) const {
+    for (const auto& request : rq_) {
+        json::PrintLine(AnswerOnRequest(request).value_or(CreateErrorMessage(request.id_)), out);
+        out << std::endl;
+    }
+
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        AnswerOnLine(line, out);
+        out << std::endl;
+    }
+}
+
+void RequestHandler::AnswerOnLine(const std::string& line, std::ostream& out) const {
+    using namespace std::literals;
+    std::optional<RequestList> request;
+    const bool timed = util::Metrics::Get().IsEnabled();
+    const auto begin = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    try {
+        std::istringstream input(line);
+        request = JSONReader::ParseStatRequest(json::Load(input).GetRoot());
+        json::PrintLine(AnswerOnRequest(*request).value_or(CreateErrorMessage(request->id_)), out);
+        if (timed && request->type_ != RequestType::Non) {
+            util::Metrics::Get().GetHistogram(GetRequestTypeName(request->type_)).Record(std::chrono::steady_clock::now() - begin);
+        }
+    }
+    catch (const std::exception& e) {
+        json::Dict error{ {"error_message"s, std::string(e.what())} };
+        if (request) {
+            error.emplace("request_id"s, request->id_);
+        }
+        json::PrintLine(error, out);
+    }
+}
+
+std::optional<json::Node> RequestHandler::AnswerOnRequest(const RequestList& request) const {
+    if (request.type_ == RequestType::Bus) {
+        auto answer = GetBusStat(request.name_);
+        if (answer != std::nullopt) {
+            return CreateBusRequest(request.id_, answer.value());
+        }
+        return CreateErrorMessage(request.id_);
+    }
+    if (request.type_ == RequestType::Stop) {
+        return CreateStopRequest(request.id_, GetBusesByStop(request.name_));
+    }
+    if (request.type_ == RequestType::Map) {
+        return CreateMap(request.id_, request.theme_, request.viewport_);
+    }
+    if (request.type_ == RequestType::Route) {
+        return CreateRoute(request.id_, request.from_, request.to_);
+    }
+    if (request.type_ == RequestType::Memory) {
+        return CreateMemoryReport(request.id_);
+    }
+    return std::nullopt;
 }
 
 std::optional<BusStat> RequestHandler::GetBusStat(const std::string_view bus_name) const {
@@ -44,22 +406,21 @@ std::optional<BusStat> RequestHandler::GetBusStat(const std::string_view bus_nam
     return bs;
 }
 
-json::Dict RequestHandler::CreateStopRequest(int id, const std::vector<std::string_view>& buses) const {
+json::Node RequestHandler::CreateStopRequest(int id, const std::vector<std::string_view>& buses) const {
     if (buses.size() && buses[0] == "no stop") {
         return CreateErrorMessage(id);
     }
     else {      
         json::Array bus_list{};
-        if (buses.size() != 0) {
-            for (const auto& bus : buses) {
-                std::string sbus = { bus.begin(),bus.end() };
-                bus_list.emplace_back(sbus);
-            }
+        bus_list.reserve(buses.size());
+        for (const auto& bus : buses) {
+            bus_list.emplace_back(std::string(bus));
         }
 
-        json::Dict req = json::Builder{}.StartDict().Key("buses").Value(bus_list)
-            .Key("request_id").Value(id).EndDict().Build().AsDict();
-        return req;
+        json::Builder builder;
+        builder.StartDict().Key("buses").Value(std::move(bus_list))
+            .Key("request_id").Value(id).EndDict();
+        return std::move(builder).Build();
     }
 }
 
@@ -79,63 +440,167 @@ std::vector<std::string_view> RequestHandler::GetBusesByStop(const std::string_v
     return stops;
 }
 
-json::Dict RequestHandler::CreateBusRequest(int id, const BusStat& bs) const {
+json::Node RequestHandler::CreateBusRequest(int id, const BusStat& bs) const {
     using namespace std::literals;
-    json::Dict req = json::Builder{}.StartDict()
+    json::Builder builder;
+    builder.StartDict()
         .Key("curvature"s).Value(bs.curvature_)
         .Key("request_id"s).Value(id)
         .Key("route_length"s).Value(bs.route_length_)
         .Key("stop_count"s).Value(bs.stops_)
         .Key("unique_stop_count"s).Value(bs.uniq_stops_)
-        .EndDict().Build().AsDict();
-    return req;
+        .EndDict();
+    return std::move(builder).Build();
 }
 
-json::Dict RequestHandler::CreateErrorMessage(int id) const {
+json::Node RequestHandler::CreateErrorMessage(int id) const {
     using namespace std::literals;
-    json::Dict req = json::Builder{}.StartDict().Key("request_id"s).Value(id)
+    json::Builder builder;
+    builder.StartDict().Key("request_id"s).Value(id)
         .Key("error_message"s).Value("not found"s)
-        .EndDict().Build().AsDict();
-    return req;
+        .EndDict();
+    return std::move(builder).Build();
 }
 
-json::Dict RequestHandler::CreateMap(int id) const {
-    std::vector<const Bus*> bl = tc_.GetBusesVector();
+json::Node RequestHandler::CreateMemoryReport(int id) const {
     using namespace std::literals;
-    json::Dict req = json::Builder{}.StartDict().Key("map"s).Value(renderer_.PrintBusRoutes(bl)
-        .str()).Key("request_id"s).Value(id)
-        .EndDict().Build().AsDict();
-    return req;
+    json::Builder builder;
+    builder.StartDict().Key("memory"s).Value(GetMemoryReport())
+        .Key("request_id"s).Value(id)
+        .EndDict();
+    return std::move(builder).Build();
 }
 
-json::Dict RequestHandler::CreateRoute(int id, const std::string& from, const std::string& to) const {
-    double time = 0;
-    auto route_way = tr_.GetRouteMap(from, to);
+json::Node RequestHandler::CreateMap(int id, const std::string& theme, const std::optional<renderer::Viewport>& viewport) const {
+    using namespace std::literals;
+    const auto theme_index = GetRenderer().FindTheme(theme);
+    if (!theme_index) {
+        return CreateErrorMessage(id);
+    }
+    json::Builder builder;
+    builder.StartDict().Key("map"s);
+    if (viewport) {
+        std::string map;
+        util::ScopedPhase phase("map_viewport");
+        GetRenderer().GetTheme(*theme_index).RenderViewport(GetMapScene(), *viewport, map);
+        builder.Value(json::EscapedString(std::move(map)));
+    }
+    else {
+        builder.Value(GetRenderedMap(*theme_index));
+    }
+    builder.Key("request_id"s).Value(id)
+        .EndDict();
+    return std::move(builder).Build();
+}
 
-    json::Array route_answer;
-    for (const auto& a : route_way) {
-        if (a.type_ == "error") {
-            return CreateErrorMessage(id);
+const TransportRouter& RequestHandler::GetRouter() const {
+    std::call_once(router_once_, [this]() {
+        router_.emplace(tc_, rstg_, route_queries_);
+        router_built_.store(true, std::memory_order_release);
+        //the choice and its reason go to the log and to the metrics
+        const bool noted = util::Metrics::Get().IsEnabled();
+        if (noted || router_log_) {
+            const RouterChoice& choice = router_->GetChoice();
+            std::ostringstream note;
+            note << GetRouterStrategyName(choice.strategy) << ", " << choice.vertices << " stops, "
+                << choice.edges << " edges: " << choice.reason;
+            if (router_log_) {
+                *router_log_ << "router: " << note.str() << std::endl;
+            }
+            if (noted) {
+                util::Metrics::Get().SetNote("router", note.str());
+            }
         }
-        json::Dict route_elemet;
-        if (a.type_ == "Wait") {
-            route_elemet["stop_name"] = a.element_name_;
-            route_elemet["time"] = a.time_;
-            route_elemet["type"] = a.type_;
+    });
+    return *router_;
+}
+
+const renderer::MapRenderer& RequestHandler::GetRenderer() const {
+    std::call_once(renderer_once_, [this]() {
+        renderer_.emplace(rs_, themes_);
+        for (size_t i = 0; i != renderer_->GetThemeCount(); ++i) {
+            map_cache_.emplace_back();
         }
-        if (a.type_ == "Bus") {
-            route_elemet["bus"] = a.element_name_;
-            route_elemet["span_count"] = a.span_;
-            route_elemet["time"] = a.time_;
-            route_elemet["type"] = a.type_;
+        renderer_built_.store(true, std::memory_order_release);
+    });
+    return *renderer_;
+}
+
+const renderer::MapScene& RequestHandler::GetMapScene() const {
+    std::call_once(scene_once_, [this]() {
+        util::ScopedPhase phase("map_scene");
+        scene_ = GetRenderer().CreateScene(tc_.GetBusesVector());
+        GetRenderer().IndexScene(scene_);
+        scene_built_.store(true, std::memory_order_release);
+    });
+    return scene_;
+}
+
+const json::EscapedString& RequestHandler::GetRenderedMap(size_t theme) const {
+    //themes share the scene, but each is drawn only once somebody asks for it
+    const renderer::MapRenderer& renderer = GetRenderer();
+    CachedMap& cached = map_cache_[theme];
+    std::call_once(cached.once, [&]() {
+        const renderer::MapScene& scene = GetMapScene();
+        util::ScopedPhase phase("map_render");
+        std::string map;
+        renderer.GetTheme(theme).RenderScene(scene, map);
+        cached.map = json::EscapedString(std::move(map));
+        cached.ready.store(true, std::memory_order_release);
+    });
+    return cached.map;
+}
+
+json::Node RequestHandler::CreateRoute(int id, const std::string& from, const std::string& to) const {
+    using namespace std::literals;
+    //one buffer per thread, a route query allocates only for the answer node
+    thread_local RouteResult route;
+    if (!GetRouter().GetRouteMap(from, to, route)) {
+        return CreateErrorMessage(id);
+    }
+
+    double time = 0;
+    json::Array route_answer;
+    route_answer.reserve(route.items.size());
+    for (const RouteItem& item : route.items) {
+        json::Dict route_element;
+        if (item.type == RouteItemType::Wait) {
+            route_element.emplace("stop_name"s, std::string(item.name));
+            route_element.emplace("time"s, item.time);
+            route_element.emplace("type"s, "Wait"s);
         }
-        time += a.time_;
-        route_answer.emplace_back(route_elemet);
+        else {
+            route_element.emplace("bus"s, std::string(item.name));
+            route_element.emplace("span_count"s, item.span);
+            route_element.emplace("time"s, item.time);
+            route_element.emplace("type"s, "Bus"s);
+        }
+        time += item.time;
+        route_answer.emplace_back(std::move(route_element));
     }
 
-    json::Dict answer = json::Builder{}.StartDict().Key("items").Value(route_answer).Key("request_id").Value(id).Key("total_time").Value(time).EndDict().Build().AsDict();
-    return answer;
+    json::Builder builder;
+    builder.StartDict().Key("items").Value(std::move(route_answer)).Key("request_id").Value(id).Key("total_time").Value(time).EndDict();
+    return std::move(builder).Build();
+
+}
 
+std::string_view RequestHandler::GetRequestTypeName(RequestType type) {
+    using namespace std::literals;
+    switch (type) {
+    case RequestType::Bus:
+        return "Bus"sv;
+    case RequestType::Stop:
+        return "Stop"sv;
+    case RequestType::Map:
+        return "Map"sv;
+    case RequestType::Route:
+        return "Route"sv;
+    case RequestType::Memory:
+        return "Memory"sv;
+    default:
+        return "Non"sv;
+    }
 }
 
 const RequestType RequestHandler::GetRequestType(const std::string& str) {
@@ -151,5 +616,8 @@ const RequestType RequestHandler::GetRequestType(const std::string& str) {
     if (str == "Route") {
         return RequestType::Route;
     }
+    if (str == "Memory") {
+        return RequestType::Memory;
+    }
     return RequestType::Non;
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <optional>
 
 #include "../json/json.h"
@@ -13,39 +17,108 @@ enum class RequestType {
     Stop,
     Map,
     Route,
+    //diagnostic request, answered with the memory report
+    Memory,
     Non
 };
 
 struct RequestList {
-    int id_;
-    RequestType type_;
+    int id_ = 0;
+    RequestType type_ = RequestType::Non;
     std::string name_;
     std::string from_;
     std::string to_;
+    //Map requests only, the whole network is drawn without it
+    std::optional<renderer::Viewport> viewport_;
+    //Map requests only, the base settings are used when it's empty
+    std::string theme_;
 };
 
 class RequestHandler {
 public:
-    RequestHandler(const transportcatalogue::TransportCatalogue& tc, const std::vector<RequestList>& rq, const renderer::MapRenderer& renderer, const RouteSetting& rstg)
-        : tc_(tc), rq_(rq), renderer_(renderer), tr_(tc, rstg)
+    //the router and the renderer are built on the first request that needs them
+    RequestHandler(const transportcatalogue::TransportCatalogue& tc, const std::vector<RequestList>& rq,
+        const RenderSettings& rs, const renderer::ThemeList& themes, const RouteSetting& rstg)
+        : tc_(tc), rq_(rq), rs_(rs), themes_(themes), rstg_(rstg)
     {}
 
-    void AnswerOnRequests() const;
+    //answers the requests given to the constructor, the router and the map they need
+    //are built in the background while the first answers are written
+    void AnswerOnRequests(std::ostream& out = std::cout) const;
+    //starts building the router and the whole map on other threads, a request that
+    //needs them waits only for the part that is not ready yet
+    void StartWarmUp(bool router, bool map) const;
+    //answers newline-delimited stat requests one at a time, one answer line per request
+    void AnswerOnStream(std::istream& input, std::ostream& out) const;
+    //answers one stat request in JSON, a request that can't be parsed gets an error_message
+    void AnswerOnLine(const std::string& line, std::ostream& out) const;
+    std::optional<json::Node> AnswerOnRequest(const RequestList& request) const;
     const static RequestType GetRequestType(const std::string& str) ;
+    static std::string_view GetRequestTypeName(RequestType type);
+    //after each batch the share of repeated queries per request type is written to out, nullptr turns it off
+    void SetDuplicateReport(std::ostream* out);
+    //the router's strategy and the reason for it are written to out when it is built, nullptr turns it off
+    void SetRouterLog(std::ostream* out);
+    //the document is freed before the handler is built, so its size is passed in
+    void SetDocumentMemory(std::optional<util::MemoryUsage> usage);
+    //heap memory per subsystem, the router and the map are counted once they are built
+    json::Dict GetMemoryReport() const;
 
 private:
     const transportcatalogue::TransportCatalogue& tc_;
     const std::vector<RequestList> rq_;
-    const renderer::MapRenderer& renderer_;
-    TransportRouter tr_;
+    const RenderSettings rs_;
+    const renderer::ThemeList themes_;
+    const RouteSetting rstg_;
+    std::ostream* duplicate_report_ = nullptr;
+    std::ostream* router_log_ = nullptr;
+    std::optional<util::MemoryUsage> document_memory_;
 
-    json::Document RequestToHandler(const std::vector<RequestList>& rl) const;
-    json::Dict CreateStopRequest(int id, const std::vector<std::string_view>& buses) const;
-    json::Dict CreateBusRequest(int id, const BusStat& bs) const;
-    json::Dict CreateErrorMessage(int id) const;
+    //Bus and Stop requests need neither of them, a batch pays only for the requests it has
+    mutable std::once_flag router_once_;
+    mutable std::optional<TransportRouter> router_;
+    //Route requests of the batch, the router picks its strategy by them
+    mutable size_t route_queries_ = ROUTE_QUERIES_UNKNOWN;
+    mutable std::once_flag renderer_once_;
+    mutable std::optional<renderer::MapRenderer> renderer_;
+    //set once the router, the renderer and the scene are ready, the memory report reads only those
+    mutable std::atomic<bool> router_built_{ false };
+    mutable std::atomic<bool> renderer_built_{ false };
+    mutable std::atomic<bool> scene_built_{ false };
 
-    json::Dict CreateMap(int id) const;
-    json::Dict CreateRoute(int id, const std::string& from, const std::string& to) const;
+    //whole map of one theme, kept escaped for JSON, every answer shares its buffer
+    struct CachedMap {
+        std::once_flag once;
+        json::EscapedString map;
+        std::atomic<bool> ready{ false };
+    };
+
+    //the catalogue and the render settings can't change during the handler's life,
+    //so the scene is built on the first Map request and a theme's map on the first one asking for it
+    mutable std::once_flag scene_once_;
+    mutable renderer::MapScene scene_;
+    //one per theme, filled when the renderer is built
+    mutable std::deque<CachedMap> map_cache_;
+
+    //declared last, so that the handler waits for the builds before its state is destroyed
+    mutable std::vector<std::future<void>> warm_ups_;
+
+    //answers are computed in parallel blocks and printed in the order of the requests
+    void RequestToHandler(const std::vector<RequestList>& rl, std::ostream& out) const;
+    //prints the answer as an array element and finds where its request_id is written
+    void PrintSharedAnswer(const RequestList& request, std::string& text, size_t& id_begin, size_t& id_end) const;
+    json::Node CreateStopRequest(int id, const std::vector<std::string_view>& buses) const;
+    json::Node CreateBusRequest(int id, const BusStat& bs) const;
+    json::Node CreateErrorMessage(int id) const;
+    json::Node CreateMemoryReport(int id) const;
+
+    const TransportRouter& GetRouter() const;
+    const renderer::MapRenderer& GetRenderer() const;
+
+    json::Node CreateMap(int id, const std::string& theme, const std::optional<renderer::Viewport>& viewport) const;
+    const renderer::MapScene& GetMapScene() const;
+    const json::EscapedString& GetRenderedMap(size_t theme) const;
+    json::Node CreateRoute(int id, const std::string& from, const std::string& to) const;
 
     std::optional<BusStat> GetBusStat(const std::string_view bus_name) const;
     std::vector<std::string_view> GetBusesByStop(const std::string_view stop_name) const;
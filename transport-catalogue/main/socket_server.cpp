@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "socket_server.h"
+
+namespace {
+    //how often the polling thread checks for a stop request and idle connections
+    const int POLL_INTERVAL_MS = 100;
+    const size_t READ_BUFFER_SIZE = 64 * 1024;
+    const int LISTEN_BACKLOG = 128;
+    //a job is cut at either limit, so a worker doesn't hold thousands of answers at once
+    const size_t MAX_JOB_LINES = 256;
+    const std::streamoff MAX_JOB_ANSWER_SIZE = 1 << 20;
+
+#ifndef _WIN32
+    bool SetNonBlocking(int fd) {
+        const int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool WouldBlock() {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+#endif
+}
+
+SocketServer::SocketServer(const RequestHandler& handler, ServerOptions options)
+    : handler_(handler), options_(std::move(options)) {
+    options_.workers = std::max<size_t>(options_.workers, 1);
+    options_.max_connections = std::max<size_t>(options_.max_connections, 1);
+    options_.max_line_size = std::max<size_t>(options_.max_line_size, 1);
+}
+
+SocketServer::~SocketServer() {
+    Stop();
+    CloseQueue();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+#ifndef _WIN32
+    for (const auto& [id, connection] : connections_) {
+        close(connection.fd);
+    }
+    for (int fd : wake_fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(options_.path.c_str());
+    }
+#endif
+}
+
+void SocketServer::Stop() {
+    stop_ = true;
+}
+
+#ifdef _WIN32
+
+void SocketServer::Run() {
+    throw ServerError("Unix domain sockets are not supported on this platform");
+}
+
+#else
+
+void SocketServer::Listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options_.path.empty() || options_.path.size() >= sizeof(address.sun_path)) {
+        throw ServerError("bad socket path '" + options_.path + "'");
+    }
+    std::memcpy(address.sun_path, options_.path.data(), options_.path.size());
+
+    if (pipe(wake_fds_) != 0 || !SetNonBlocking(wake_fds_[0]) || !SetNonBlocking(wake_fds_[1])) {
+        throw ServerError("can't create pipe: " + std::string(std::strerror(errno)));
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw ServerError("can't create socket: " + std::string(std::strerror(errno)));
+    }
+    unlink(options_.path.c_str());
+    if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listen_fd_, LISTEN_BACKLOG) != 0 || !SetNonBlocking(listen_fd_)) {
+        const std::string error = std::strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        throw ServerError("can't listen on " + options_.path + ": " + error);
+    }
+}
+
+void SocketServer::Run() {
+    Listen();
+    workers_.reserve(options_.workers);
+    for (size_t i = 0; i != options_.workers; ++i) {
+        workers_.emplace_back([this] { Work(); });
+    }
+
+    std::vector<pollfd> polled;
+    std::vector<uint64_t> polled_ids;
+    while (!stop_) {
+        polled.clear();
+        polled_ids.clear();
+        polled.push_back({ wake_fds_[0], POLLIN, 0 });
+        polled.push_back({ listen_fd_, static_cast<short>(connections_.size() < options_.max_connections ? POLLIN : 0), 0 });
+        for (const auto& [id, connection] : connections_) {
+            //a connection is read again only when its previous lines are answered and sent,
+            //so a client can't run ahead of the workers; one waiting for a worker isn't polled
+            short events = 0;
+            if (connection.sent < connection.output.size()) {
+                events = POLLOUT;
+            }
+            else if (!connection.busy && !connection.closing && connection.lines.empty()) {
+                events = POLLIN;
+            }
+            polled.push_back({ events ? connection.fd : -1, events, 0 });
+            polled_ids.push_back(id);
+        }
+
+        if (poll(polled.data(), polled.size(), POLL_INTERVAL_MS) < 0 && errno != EINTR) {
+            break;
+        }
+        if (polled[0].revents & POLLIN) {
+            char drain[256];
+            while (read(wake_fds_[0], drain, sizeof(drain)) > 0) {
+            }
+            CollectResults();
+        }
+        if (polled[1].revents & POLLIN) {
+            Accept();
+        }
+        for (size_t i = 0; i != polled_ids.size(); ++i) {
+            const short revents = polled[i + 2].revents;
+            if (!revents) {
+                continue;
+            }
+            const auto it = connections_.find(polled_ids[i]);
+            if (it == connections_.end()) {
+                continue;
+            }
+            bool keep = !(revents & (POLLERR | POLLNVAL));
+            if (keep && (revents & POLLOUT)) {
+                keep = Write(it->second);
+                if (keep) {
+                    Dispatch(it->first, it->second);
+                }
+            }
+            if (keep && (revents & (POLLIN | POLLHUP))) {
+                keep = Read(it->first, it->second);
+            }
+            if (!keep) {
+                CloseConnection(it->first);
+            }
+        }
+
+        //closing connections go once their answers are out, idle ones after the timeout,
+        //and the ones whose client stopped taking the answers after the send timeout
+        const Clock::time_point now = Clock::now();
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            const Connection& connection = it->second;
+            const bool unsent = connection.sent < connection.output.size();
+            const bool settled = !connection.busy && !unsent && connection.lines.empty() && !connection.line_too_long;
+            const bool idle = options_.idle_timeout.count() > 0 && now - connection.last_active > options_.idle_timeout;
+            const bool stalled = unsent && options_.send_timeout.count() > 0 && now - connection.last_active > options_.send_timeout;
+            if ((settled && (connection.closing || idle)) || stalled) {
+                close(connection.fd);
+                it = connections_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    //connections are cut off, the answers being prepared are dropped
+    CloseQueue();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    for (const auto& [id, connection] : connections_) {
+        close(connection.fd);
+    }
+    connections_.clear();
+}
+
+void SocketServer::Accept() {
+    while (connections_.size() < options_.max_connections) {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        if (!SetNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        Connection& connection = connections_[next_connection_++];
+        connection.fd = fd;
+        connection.last_active = Clock::now();
+    }
+}
+
+bool SocketServer::Read(uint64_t id, Connection& connection) {
+    char buffer[READ_BUFFER_SIZE];
+    const ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (n < 0) {
+        return WouldBlock();
+    }
+    if (n == 0) {
+        //an unterminated last line is answered as in the --ndjson mode
+        if (connection.input.find_first_not_of(" \t\r") != std::string::npos) {
+            connection.lines.push_back(std::move(connection.input));
+        }
+        connection.input.clear();
+        connection.closing = true;
+        Dispatch(id, connection);
+        return true;
+    }
+    connection.last_active = Clock::now();
+    connection.input.append(buffer, static_cast<size_t>(n));
+
+    size_t begin = 0;
+    for (size_t end = connection.input.find('\n'); end != std::string::npos; end = connection.input.find('\n', begin)) {
+        if (end - begin > options_.max_line_size) {
+            connection.line_too_long = true;
+            break;
+        }
+        std::string line = connection.input.substr(begin, end - begin);
+        begin = end + 1;
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            connection.lines.push_back(std::move(line));
+        }
+    }
+    if (!connection.line_too_long && connection.input.size() - begin > options_.max_line_size) {
+        connection.line_too_long = true;
+    }
+    if (connection.line_too_long) {
+        //the rest of the stream can't be split into requests
+        connection.input.clear();
+        connection.closing = true;
+    }
+    else {
+        connection.input.erase(0, begin);
+    }
+    Dispatch(id, connection);
+    return true;
+}
+
+void SocketServer::Dispatch(uint64_t id, Connection& connection) {
+    if (connection.busy || connection.sent < connection.output.size()
+        || (connection.lines.empty() && !connection.line_too_long)) {
+        return;
+    }
+    Job job;
+    job.connection = id;
+    const size_t count = std::min(connection.lines.size(), MAX_JOB_LINES);
+    job.lines.assign(std::make_move_iterator(connection.lines.begin()),
+                     std::make_move_iterator(connection.lines.begin() + count));
+    connection.lines.erase(connection.lines.begin(), connection.lines.begin() + count);
+    //the error goes after the answers of all the lines before the long one
+    if (connection.lines.empty()) {
+        job.line_too_long = connection.line_too_long;
+        connection.line_too_long = false;
+    }
+    connection.busy = true;
+    PushJob(std::move(job));
+}
+
+bool SocketServer::Write(Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        const ssize_t n = send(connection.fd, connection.output.data() + connection.sent,
+                               connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            return WouldBlock();
+        }
+        connection.sent += static_cast<size_t>(n);
+        connection.last_active = Clock::now();
+    }
+    connection.output.clear();
+    connection.sent = 0;
+    return true;
+}
+
+void SocketServer::CollectResults() {
+    std::vector<Result> results;
+    {
+        std::lock_guard lock(mutex_);
+        results.swap(results_);
+    }
+    for (Result& result : results) {
+        const auto it = connections_.find(result.connection);
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = it->second;
+        connection.busy = false;
+        connection.output = std::move(result.answers);
+        connection.sent = 0;
+        connection.lines.insert(connection.lines.begin(), std::make_move_iterator(result.unanswered.begin()),
+                                std::make_move_iterator(result.unanswered.end()));
+        connection.line_too_long = connection.line_too_long || result.line_too_long;
+        //most answers fit in the socket buffer and go out without waiting for the next poll
+        if (!Write(connection)) {
+            CloseConnection(result.connection);
+            continue;
+        }
+        Dispatch(result.connection, connection);
+    }
+}
+
+void SocketServer::CloseConnection(uint64_t id) {
+    const auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    close(it->second.fd);
+    //a result still being prepared for it is dropped in CollectResults
+    connections_.erase(it);
+}
+
+void SocketServer::Work() {
+    using namespace std::literals;
+    Job job;
+    std::ostringstream answers;
+    while (PopJob(job)) {
+        answers.str(std::string());
+        Result result;
+        result.connection = job.connection;
+        size_t answered = 0;
+        while (answered != job.lines.size() && answers.tellp() < MAX_JOB_ANSWER_SIZE) {
+            handler_.AnswerOnLine(job.lines[answered++], answers);
+            answers << '\n';
+        }
+        if (answered != job.lines.size()) {
+            result.unanswered.assign(std::make_move_iterator(job.lines.begin() + answered),
+                                     std::make_move_iterator(job.lines.end()));
+            result.line_too_long = job.line_too_long;
+        }
+        else if (job.line_too_long) {
+            json::PrintLine(json::Dict{ {"error_message"s, "request line is longer than "s + std::to_string(options_.max_line_size) + " bytes"s} }, answers);
+            answers << '\n';
+        }
+        result.answers = answers.str();
+        {
+            std::lock_guard lock(mutex_);
+            results_.push_back(std::move(result));
+        }
+        const char wake = 0;
+        //the pipe is full only if the polling thread is already due to wake up
+        [[maybe_unused]] const ssize_t written = write(wake_fds_[1], &wake, 1);
+    }
+}
+
+#endif
+
+void SocketServer::PushJob(Job job) {
+    {
+        std::lock_guard lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    not_empty_.notify_one();
+}
+
+bool SocketServer::PopJob(Job& job) {
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !jobs_.empty(); });
+    if (closed_) {
+        return false;
+    }
+    job = std::move(jobs_.front());
+    jobs_.pop_front();
+    return true;
+}
+
+void SocketServer::CloseQueue() {
+    {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+    }
+    not_empty_.notify_all();
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "request_handler.h"
+
+class ServerError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+struct ServerOptions {
+    //path of the Unix domain socket, a stale socket file is replaced
+    std::string path;
+    //threads answering requests
+    size_t workers = std::thread::hardware_concurrency();
+    //open connections, accepting pauses when there are this many
+    size_t max_connections = 1024;
+    //a longer request line is answered with an error and the connection is closed
+    size_t max_line_size = 1 << 20;
+    //a connection with no input and nothing to answer for this long is closed, zero keeps it open
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(60);
+    //a connection whose client takes none of its answers for this long is closed, zero waits forever
+    std::chrono::milliseconds send_timeout = std::chrono::seconds(60);
+};
+
+// Serves newline-delimited stat requests over a Unix domain socket. The catalogue,
+// the router and the renderer are built once by the handler and shared by every
+// connection. One thread polls all the connections and hands their complete lines
+// to the workers a few at a time; the lines of one connection are answered in order,
+// one answer line per request, and the connection is not read again until all of
+// them are answered and sent
+class SocketServer {
+public:
+    SocketServer(const RequestHandler& handler, ServerOptions options);
+    ~SocketServer();
+
+    SocketServer(const SocketServer&) = delete;
+    SocketServer& operator=(const SocketServer&) = delete;
+
+    //serves connections until Stop is called, throws ServerError if the socket can't be opened
+    void Run();
+    //safe to call from a signal handler, Run returns within a poll interval
+    void Stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        int fd = -1;
+        //the incomplete last line
+        std::string input;
+        //complete lines waiting for a worker
+        std::deque<std::string> lines;
+        //the lines are followed by one that is too long
+        bool line_too_long = false;
+        //answers not sent yet
+        std::string output;
+        size_t sent = 0;
+        //a worker is answering the lines read last
+        bool busy = false;
+        //the client has closed its side or broken the protocol, the connection is closed
+        //once the answers are sent
+        bool closing = false;
+        //last input or sent answer bytes
+        Clock::time_point last_active;
+    };
+
+    //lines of one connection, answered by a worker in order
+    struct Job {
+        uint64_t connection = 0;
+        std::vector<std::string> lines;
+        //the lines are followed by one that is too long
+        bool line_too_long = false;
+    };
+
+    //a worker stops once the answers grow too big, the lines it hasn't answered come back
+    struct Result {
+        uint64_t connection = 0;
+        std::string answers;
+        std::vector<std::string> unanswered;
+        bool line_too_long = false;
+    };
+
+    const RequestHandler& handler_;
+    ServerOptions options_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stop_{ false };
+
+    //owned by the thread in Run, connections are keyed by a serial number since fds are reused
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t next_connection_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::deque<Job> jobs_;
+    std::vector<Result> results_;
+    bool closed_ = false;
+    //a worker writes a byte to the pipe to wake the polling thread when a result is ready
+    int wake_fds_[2] = { -1, -1 };
+
+    std::vector<std::thread> workers_;
+
+    void Listen();
+    void Accept();
+    //return false when the connection is to be closed
+    bool Read(uint64_t id, Connection& connection);
+    bool Write(Connection& connection);
+    //hands the next lines to a worker when the previous answers are sent
+    void Dispatch(uint64_t id, Connection& connection);
+    void CollectResults();
+    void CloseConnection(uint64_t id);
+
+    void PushJob(Job job);
+    //blocks until there is a job or the queue is closed, false after closing
+    bool PopJob(Job& job);
+    void CloseQueue();
+    void Work();
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "../data/ranges.h"
+#include "../util/memory_usage.h"
 
 #include <cstdlib>
 #include <vector>
@@ -31,6 +32,7 @@ public:
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    util::MemoryUsage GetMemoryUsage() const;
 
 private:
     std::vector<Edge<Weight>> edges_;
@@ -76,4 +78,15 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+util::MemoryUsage DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    util::MemoryUsage usage;
+    usage.AddVector(edges_);
+    usage.AddVector(incidence_lists_);
+    for (const auto& list : incidence_lists_) {
+        usage.AddVector(list);
+    }
+    return usage;
+}
 }  // namespace graph
\ No newline at end of file
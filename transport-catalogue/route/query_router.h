@@ -0,0 +1,123 @@
+#pragma once
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Finds every route on demand with Dijkstra's algorithm. Nothing is precomputed, so it
+// costs no memory beyond the graph, while a query visits up to all of its edges.
+// The search state is kept per thread and reused between queries
+template <typename Weight>
+class QueryRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    explicit QueryRouter(const Graph& graph);
+
+    // Fills edges with the route and returns its weight, the buffer is reused between calls
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+private:
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        //a vertex is reached in the current search if its stamp equals the generation
+        std::vector<uint32_t> stamps;
+        uint32_t generation = 0;
+        std::vector<std::pair<Weight, VertexId>> queue;
+    };
+
+    const Graph& graph_;
+
+    SearchState& GetState() const;
+};
+
+template <typename Weight>
+QueryRouter<Weight>::QueryRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < Weight{}) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+typename QueryRouter<Weight>::SearchState& QueryRouter<Weight>::GetState() const {
+    thread_local SearchState state;
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (state.stamps.size() != vertex_count) {
+        state.weights.assign(vertex_count, Weight{});
+        state.prev_edges.assign(vertex_count, std::nullopt);
+        state.stamps.assign(vertex_count, 0);
+        state.generation = 0;
+    }
+    //stamps are cleared only when the generation wraps around
+    if (++state.generation == 0) {
+        std::fill(state.stamps.begin(), state.stamps.end(), 0);
+        state.generation = 1;
+    }
+    state.queue.clear();
+    return state;
+}
+
+template <typename Weight>
+std::optional<Weight> QueryRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                      std::vector<EdgeId>& edges) const {
+    edges.clear();
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of the graph");
+    }
+    SearchState& state = GetState();
+    auto reach = [&state](VertexId vertex, Weight weight, std::optional<EdgeId> edge) {
+        state.stamps[vertex] = state.generation;
+        state.weights[vertex] = weight;
+        state.prev_edges[vertex] = edge;
+        state.queue.emplace_back(weight, vertex);
+        std::push_heap(state.queue.begin(), state.queue.end(), std::greater<>());
+    };
+
+    reach(from, Weight{}, std::nullopt);
+    bool found = false;
+    while (!state.queue.empty()) {
+        std::pop_heap(state.queue.begin(), state.queue.end(), std::greater<>());
+        const auto [weight, vertex] = state.queue.back();
+        state.queue.pop_back();
+        //a vertex is queued again each time its weight drops, the stale entries are skipped
+        if (weight > state.weights[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            found = true;
+            break;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate = weight + edge.weight;
+            if (state.stamps[edge.to] != state.generation || candidate < state.weights[edge.to]) {
+                reach(edge.to, candidate, edge_id);
+            }
+        }
+    }
+    if (!found) {
+        return std::nullopt;
+    }
+
+    for (std::optional<EdgeId> edge_id = state.prev_edges[to]; edge_id;
+         edge_id = state.prev_edges[graph_.GetEdge(*edge_id).from]) {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return state.weights[to];
+}
+
+}  // namespace graph
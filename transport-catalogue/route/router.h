@@ -27,6 +27,13 @@ public:
     };
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Fills edges with the route and returns its weight, the buffer is reused between calls
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    // Heap memory of the table of routes between all pairs of vertices, the graph is not counted
+    util::MemoryUsage GetMemoryUsage() const;
+    // Bytes the table takes for a graph of vertex_count vertices, known before it is built
+    static size_t EstimateTableBytes(size_t vertex_count);
 
 private:
     struct RouteInternalData {
@@ -96,12 +103,22 @@ Router<Weight>::Router(const Graph& graph)
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
+    std::vector<EdgeId> edges;
+    const std::optional<Weight> weight = BuildRoute(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                 std::vector<EdgeId>& edges) const {
+    edges.clear();
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
          edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
@@ -109,8 +126,23 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
         edges.push_back(*edge_id);
     }
     std::reverse(edges.begin(), edges.end());
+    return route_internal_data->weight;
+}
 
-    return RouteInfo{weight, std::move(edges)};
+template <typename Weight>
+size_t Router<Weight>::EstimateTableBytes(size_t vertex_count) {
+    using Row = typename RoutesInternalData::value_type;
+    return vertex_count * (sizeof(Row) + vertex_count * sizeof(typename Row::value_type));
+}
+
+template <typename Weight>
+util::MemoryUsage Router<Weight>::GetMemoryUsage() const {
+    util::MemoryUsage usage;
+    usage.AddVector(routes_internal_data_);
+    for (const auto& row : routes_internal_data_) {
+        usage.AddVector(row);
+    }
+    return usage;
 }
 
 }  // namespace graph
\ No newline at end of file
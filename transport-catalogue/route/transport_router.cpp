@@ -1,66 +1,142 @@
+#include <cmath>
+#include <sstream>
+
 #include "transport_router.h"
+#include "../util/metrics.h"
 
+namespace {
+	//measured costs of the two strategies: a relaxation step of the all-pairs table
+	//and an edge scanned by the search of one query, including its share of the heap
+	const double ALL_PAIRS_STEP_NS = 0.8;
+	const double QUERY_EDGE_NS = 3.5;
+	const size_t BYTES_IN_MIB = 1024 * 1024;
+	//when Route requests come one at a time, as many are assumed to come,
+	//and the first of them waits for the table no longer than this
+	const size_t ASSUMED_STREAM_QUERIES = 100000;
+	const double MAX_STREAM_BUILD_MS = 1000;
+}
 
-void TransportRouter::CreateRouteMap() {
-	TranslateStopToId();
-	FillRouteMap();
+std::string_view GetRouterStrategyName(RouterStrategy strategy) {
+	using namespace std::literals;
+	switch (strategy) {
+	case RouterStrategy::AllPairs:
+		return "all_pairs"sv;
+	case RouterStrategy::PerQuery:
+		return "per_query"sv;
+	default:
+		return "auto"sv;
+	}
+}
+
+RouterChoice TransportRouter::ChooseStrategy(const RouteSetting& rstg, size_t vertices, size_t edges, size_t route_queries) {
+	RouterChoice choice;
+	choice.vertices = vertices;
+	choice.edges = edges;
+	choice.route_queries = route_queries;
+	choice.table_bytes = graph::Router<double>::EstimateTableBytes(vertices);
+
+	std::ostringstream reason;
+	if (rstg.strategy != RouterStrategy::Auto) {
+		choice.strategy = rstg.strategy;
+		reason << "forced by routing_settings";
+	}
+	else if (choice.table_bytes > rstg.router_memory_mb * BYTES_IN_MIB) {
+		choice.strategy = RouterStrategy::PerQuery;
+		reason << "the table of " << choice.table_bytes / BYTES_IN_MIB << " MiB is over the budget of "
+			<< rstg.router_memory_mb << " MiB";
+	}
+	else {
+		//the table takes a step for every triple of vertices, a search scans the edges
+		//and pushes the vertices it reaches through the heap
+		const bool unknown = route_queries == ROUTE_QUERIES_UNKNOWN;
+		const size_t queries = unknown ? ASSUMED_STREAM_QUERIES : route_queries;
+		const double n = static_cast<double>(vertices);
+		const double all_pairs_ms = n * n * n * ALL_PAIRS_STEP_NS / 1e6;
+		const double per_query_ms = static_cast<double>(queries)
+			* (static_cast<double>(edges) + n * std::log2(n + 2)) * QUERY_EDGE_NS / 1e6;
+		if (unknown && all_pairs_ms > MAX_STREAM_BUILD_MS) {
+			choice.strategy = RouterStrategy::PerQuery;
+			reason << "the number of queries is unknown and the table would take an estimated "
+				<< all_pairs_ms << " ms to build, over the " << MAX_STREAM_BUILD_MS << " ms the first query may wait";
+		}
+		else {
+			choice.strategy = all_pairs_ms < per_query_ms ? RouterStrategy::AllPairs : RouterStrategy::PerQuery;
+			reason << "estimated " << all_pairs_ms << " ms to build the table against "
+				<< per_query_ms << " ms for " << queries << (unknown ? " assumed" : "") << " searches";
+		}
+	}
+	choice.reason = reason.str();
+	return choice;
 }
 
-void TransportRouter::TranslateStopToId() {
-	size_t id = 0;
-	stop_to_id_.reserve(tc_.GetStops().size());
-	id_to_stop_.reserve(tc_.GetStops().size());
-	for (const Stop& stop : tc_.GetStops()) {
-		stop_to_id_[stop.name] = id;
-		id_to_stop_[id] = stop.name;
-		++id;
+const RouterChoice& TransportRouter::GetChoice() const {
+	return choice_;
+}
+
+void TransportRouter::CreateRouteMap(size_t route_queries) {
+	FillRouteMap();
+	choice_ = ChooseStrategy(rstg_, stops_graph_.GetVertexCount(), stops_graph_.GetEdgeCount(), route_queries);
+	if (choice_.strategy == RouterStrategy::PerQuery) {
+		query_rt_ = std::make_unique<graph::QueryRouter<double>>(stops_graph_);
+	}
+	else {
+		util::ScopedPhase router_phase("router_build");
+		rt_ = std::make_unique<graph::Router<double>>(stops_graph_);
 	}
 }
 
 void TransportRouter::FillRouteMap() {
+	util::ScopedPhase fill_phase("fill_route_map");
 	for (const Bus& bus : tc_.GetBuses()) {
 		for (size_t i = 0; i != bus.stops.size() - 1; ++i) {
 			double total_time = rstg_.bus_wait_time;
 
 			for (size_t j = i + 1; j != bus.stops.size(); ++j) {
 				total_time += CalcTimeBetweenStops(bus.stops.at(j - 1), bus.stops.at(j));
-				stops_graph_.AddEdge({ stop_to_id_.at(bus.stops.at(i)->name), stop_to_id_.at(bus.stops.at(j)->name), total_time });
-				edge_param.emplace_back(bus.name, stop_to_id_.at(bus.stops.at(i)->name),
-					stop_to_id_.at(bus.stops.at(j)->name), j-i, total_time);
+				stops_graph_.AddEdge({ bus.stops.at(i)->id, bus.stops.at(j)->id, total_time });
+				edge_param.emplace_back(bus.name, bus.stops.at(i)->id, j - i, total_time);
 			}
 		}
 	}
-	rt_ = new graph::Router{ stops_graph_ };
 }
 
-std::vector<RouteResult> TransportRouter::GetRouteMap(const std::string& stop1, const std::string& stop2) const {
-	std::vector<RouteResult> result;
-
-	if (!stop_to_id_.count(stop1) || !stop_to_id_.count(stop2)) {
-		RouteResult ep("error");
-		result.emplace_back(ep);
-		return result;
+bool TransportRouter::GetRouteMap(std::string_view stop1, std::string_view stop2, RouteResult& result) const {
+	result.items.clear();
+	const Stop* from = tc_.GetStop(stop1);
+	const Stop* to = tc_.GetStop(stop2);
+	if (!from || !to) {
+		return false;
 	}
-
-	auto route = rt_->BuildRoute(stop_to_id_.at(stop1), stop_to_id_.at(stop2));
-
-	if (!route.has_value()) {
-		RouteResult ep("error");
-		result.emplace_back(ep);
-		return result;
+	const auto weight = rt_ ? rt_->BuildRoute(from->id, to->id, result.edges)
+		: query_rt_->BuildRoute(from->id, to->id, result.edges);
+	if (!weight) {
+		return false;
 	}
 
-	for (size_t i = 0; i != route.value().edges.size(); ++i) {
-		RouteResult wait("Wait", id_to_stop_.at(edge_param[route.value().edges[i]].from_), rstg_.bus_wait_time, 0);
-		result.emplace_back(wait);
-
-		RouteResult way("Bus", edge_param[route.value().edges[i]].type_, edge_param[route.value().edges[i]].time_ - rstg_.bus_wait_time, edge_param[route.value().edges[i]].span_);
-		result.emplace_back(way);
+	const auto& stops = tc_.GetStops();
+	for (const graph::EdgeId edge : result.edges) {
+		const EdgeParam& param = edge_param[edge];
+		result.items.push_back({ RouteItemType::Wait, stops[param.from_].name, rstg_.bus_wait_time, 0 });
+		result.items.push_back({ RouteItemType::Bus, param.bus_, param.time_ - rstg_.bus_wait_time, static_cast<int>(param.span_) });
 	}
+	return true;
+}
 
-	return result;
+util::MemoryUsage TransportRouter::GetGraphMemory() const {
+	return stops_graph_.GetMemoryUsage();
 }
 
+util::MemoryUsage TransportRouter::GetTableMemory() const {
+	//the search keeps only per-thread scratch space, it's not counted
+	return rt_ ? rt_->GetMemoryUsage() : util::MemoryUsage{};
+}
+
+util::MemoryUsage TransportRouter::GetMetadataMemory() const {
+	util::MemoryUsage usage;
+	usage.AddVector(edge_param);
+	usage.AddAllocation(rt_ ? sizeof(graph::Router<double>) : sizeof(graph::QueryRouter<double>));
+	return usage;
+}
 
 double TransportRouter::CalcTimeBetweenStops(const Stop* stop1, const Stop* stop2) const {
 	if (stop1 == stop2) {
@@ -1,66 +1,118 @@
 #pragma once
 #include "router.h"
+#include "query_router.h"
 #include "../data/transport_catalogue.h"
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
 
 const int RATIO_MINUTES_TO_HOURS = 60;
 const int RATIO_KILOMETERS_TO_METERS = 1000;
 
-struct RouteResult {
-	std::string type_;
-	std::string element_name_;
-	double time_ = 0;
-	int span_ = 0;
+enum class RouteItemType {
+	Wait,
+	Bus
+};
 
-	RouteResult() = default;
+//a wait at a stop or a ride on a bus, names are views into the catalogue
+struct RouteItem {
+	RouteItemType type;
+	//stop name for a wait, bus name for a ride
+	std::string_view name;
+	double time = 0;
+	//stops passed on the ride, 0 for a wait
+	int span = 0;
+};
 
-	RouteResult(const std::string& str) :
-		type_(str) {}
+//items of the last found route and the scratch space of the search, kept between
+//queries so that a route doesn't allocate once the buffers have grown
+struct RouteResult {
+	std::vector<RouteItem> items;
+	std::vector<graph::EdgeId> edges;
+};
 
-	RouteResult(const std::string_view type, const std::string_view ename, double time, int span) :
-		type_(type), element_name_(ename), time_(time), span_(span) {};
+enum class RouterStrategy {
+	//picked by the size of the network and the number of Route requests
+	Auto,
+	//a table of routes between all pairs of stops, built once, answers in a lookup
+	AllPairs,
+	//a search per query, nothing to build and no memory beyond the graph
+	PerQuery
 };
 
 struct RouteSetting {
 	double bus_wait_time = 6;
 	double bus_velocity = 40;
+	RouterStrategy strategy = RouterStrategy::Auto;
+	//the all-pairs table is never built beyond this size, in MiB
+	size_t router_memory_mb = 1024;
 };
 
+//Route requests come one at a time and there is no telling how many
+const size_t ROUTE_QUERIES_UNKNOWN = std::numeric_limits<size_t>::max();
+
+//strategy chosen for a network and the numbers behind the choice
+struct RouterChoice {
+	RouterStrategy strategy = RouterStrategy::AllPairs;
+	size_t vertices = 0;
+	size_t edges = 0;
+	size_t route_queries = ROUTE_QUERIES_UNKNOWN;
+	size_t table_bytes = 0;
+	//why the strategy was chosen, for the log
+	std::string reason;
+};
+
+std::string_view GetRouterStrategyName(RouterStrategy strategy);
+
 struct EdgeParam {
-	std::string type_;
+	std::string_view bus_;
 	size_t from_;
-	size_t to_;
 	size_t span_;
 	double time_;
 
-	EdgeParam(const std::string& type, size_t from, size_t to, size_t span, double time) :
-		type_(type), from_(from), to_(to), span_(span), time_(time) {}
+	EdgeParam(std::string_view bus, size_t from, size_t span, double time) :
+		bus_(bus), from_(from), span_(span), time_(time) {}
 };
 
 
 class TransportRouter {
 public:
-	TransportRouter(const transportcatalogue::TransportCatalogue& tc, const RouteSetting& rstg)
+	//route_queries is the number of Route requests expected, it decides the strategy
+	//together with the size of the network unless the settings force one
+	TransportRouter(const transportcatalogue::TransportCatalogue& tc, const RouteSetting& rstg,
+		size_t route_queries = ROUTE_QUERIES_UNKNOWN)
 		:tc_(tc), rstg_(rstg), stops_graph_(tc.GetStopsCount())
 	{
-		CreateRouteMap();
+		CreateRouteMap(route_queries);
 	}
 
-	std::vector<RouteResult> GetRouteMap(const std::string& stop1, const std::string& stop2) const ;
+	static RouterChoice ChooseStrategy(const RouteSetting& rstg, size_t vertices, size_t edges, size_t route_queries);
+	const RouterChoice& GetChoice() const;
+
+	//fills result with the fastest route, false if a stop is unknown or can't be reached
+	bool GetRouteMap(std::string_view stop1, std::string_view stop2, RouteResult& result) const;
+
+	//heap memory of the stops graph, of the router's table and of the edge parameters
+	util::MemoryUsage GetGraphMemory() const;
+	util::MemoryUsage GetTableMemory() const;
+	util::MemoryUsage GetMetadataMemory() const;
 
 private:
 	const transportcatalogue::TransportCatalogue& tc_;
 	RouteSetting rstg_;
 
 	graph::DirectedWeightedGraph<double> stops_graph_;
-	const graph::Router<double>* rt_;
+	RouterChoice choice_;
+	//one of them is built, as the choice says
+	std::unique_ptr<graph::Router<double>> rt_;
+	std::unique_ptr<graph::QueryRouter<double>> query_rt_;
 
-	std::unordered_map<std::string_view, size_t> stop_to_id_;
-	std::unordered_map<size_t, std::string_view> id_to_stop_;
+	//the vertex of a stop is its id in the catalogue
 	std::vector<EdgeParam> edge_param;
 
-	void CreateRouteMap();
-	void TranslateStopToId();
+	void CreateRouteMap(size_t route_queries);
 	void FillRouteMap();
 
 	double CalcTimeBetweenStops(const Stop* stop1, const Stop* stop2) const;
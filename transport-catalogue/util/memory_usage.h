@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace util {
+
+    // Heap memory held by a data structure: the bytes of its allocations and their number.
+    // The node and block sizes of the standard containers follow libstdc++, allocator
+    // overhead is not counted, so the numbers are estimates of what the structure asks for
+    struct MemoryUsage {
+        size_t bytes = 0;
+        size_t allocations = 0;
+
+        MemoryUsage& operator+=(const MemoryUsage& other) {
+            bytes += other.bytes;
+            allocations += other.allocations;
+            return *this;
+        }
+
+        void AddAllocation(size_t size) {
+            if (size) {
+                bytes += size;
+                ++allocations;
+            }
+        }
+
+        void AddString(const std::string& str) {
+            //short strings are kept inside the object
+            if (str.capacity() > std::string().capacity()) {
+                AddAllocation(str.capacity() + 1);
+            }
+        }
+
+        template <typename T>
+        void AddVector(const std::vector<T>& vec) {
+            AddAllocation(vec.capacity() * sizeof(T));
+        }
+
+        //blocks of 512 bytes and the array of pointers to them
+        template <typename T>
+        void AddDeque(const std::deque<T>& deq) {
+            const size_t per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+            const size_t blocks = deq.size() / per_block + 1;
+            bytes += blocks * per_block * sizeof(T);
+            allocations += blocks;
+            AddAllocation(std::max<size_t>(blocks + 2, 8) * sizeof(void*));
+        }
+
+        //unordered containers: a node per element and the bucket array, the hash is kept
+        //in the node unless the key is a number or a pointer;
+        //the elements' own allocations are added by the caller
+        template <typename HashTable>
+        void AddHashTable(const HashTable& table) {
+            using Key = typename HashTable::key_type;
+            const bool cached_hash = !std::is_integral_v<Key> && !std::is_pointer_v<Key>;
+            const size_t node = sizeof(void*) + sizeof(typename HashTable::value_type) + (cached_hash ? sizeof(size_t) : 0);
+            bytes += table.size() * node;
+            allocations += table.size();
+            //a table with one bucket keeps it inside the object
+            if (table.bucket_count() > 1) {
+                AddAllocation(table.bucket_count() * sizeof(void*));
+            }
+        }
+
+        //ordered containers: a red-black tree node per element
+        template <typename Tree>
+        void AddTree(const Tree& tree) {
+            const size_t node = 4 * sizeof(void*) + sizeof(typename Tree::value_type);
+            bytes += tree.size() * node;
+            allocations += tree.size();
+        }
+    };
+
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#include "metrics.h"
+
+namespace util {
+
+    void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+        const int64_t ns = std::max<int64_t>(duration.count(), 1);
+        const size_t bucket = std::min(BUCKET_COUNT - 1,
+            static_cast<size_t>(std::log2(static_cast<double>(ns)) * BUCKETS_PER_DOUBLING));
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t max = max_.load(std::memory_order_relaxed);
+        while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t LatencyHistogram::GetCount() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds LatencyHistogram::GetPercentile(double q) const {
+        const uint64_t count = GetCount();
+        if (count == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        //rank of the wanted duration, counted from 1
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket != BUCKET_COUNT; ++bucket) {
+            seen += buckets_[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                const double upper = std::exp2(static_cast<double>(bucket + 1) / BUCKETS_PER_DOUBLING);
+                return std::min(GetMax(), std::chrono::nanoseconds(static_cast<int64_t>(upper)));
+            }
+        }
+        return GetMax();
+    }
+
+    std::chrono::nanoseconds LatencyHistogram::GetMax() const {
+        return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+    }
+
+    Metrics& Metrics::Get() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    void Metrics::Enable() {
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    void Metrics::AddPhase(std::string_view name, std::chrono::nanoseconds duration) {
+        std::lock_guard lock(mutex_);
+        auto it = std::find_if(phases_.begin(), phases_.end(), [name](const PhaseTime& phase) {
+            return phase.name == name; });
+        if (it == phases_.end()) {
+            it = phases_.insert(phases_.end(), PhaseTime{ std::string(name) });
+        }
+        ++it->count;
+        it->total += duration;
+    }
+
+    LatencyHistogram& Metrics::GetHistogram(std::string_view name) {
+        std::lock_guard lock(mutex_);
+        for (auto& [histogram_name, histogram] : histograms_) {
+            if (histogram_name == name) {
+                return histogram;
+            }
+        }
+        //the histogram holds atomics and can't be moved, so it is built in place
+        histograms_.emplace_back(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple());
+        return histograms_.back().second;
+    }
+
+    void Metrics::SetNote(std::string_view name, std::string text) {
+        std::lock_guard lock(mutex_);
+        for (auto& [note_name, note_text] : notes_) {
+            if (note_name == name) {
+                note_text = std::move(text);
+                return;
+            }
+        }
+        notes_.emplace_back(std::string(name), std::move(text));
+    }
+
+    std::vector<PhaseTime> Metrics::GetPhases() const {
+        std::lock_guard lock(mutex_);
+        return phases_;
+    }
+
+    std::vector<std::pair<std::string, const LatencyHistogram*>> Metrics::GetHistograms() const {
+        std::lock_guard lock(mutex_);
+        std::vector<std::pair<std::string, const LatencyHistogram*>> histograms;
+        for (const auto& [name, histogram] : histograms_) {
+            histograms.emplace_back(name, &histogram);
+        }
+        return histograms;
+    }
+
+    std::vector<std::pair<std::string, std::string>> Metrics::GetNotes() const {
+        std::lock_guard lock(mutex_);
+        return notes_;
+    }
+
+}
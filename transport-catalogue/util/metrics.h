@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+    // Log-scale histogram of durations with 8 buckets per doubling, so a percentile is
+    // off by at most 9%. Recording is lock-free and may be done from any thread
+    class LatencyHistogram {
+    public:
+        void Record(std::chrono::nanoseconds duration);
+
+        uint64_t GetCount() const;
+        //upper bound of the bucket holding the share q of the recorded durations, q in [0, 1]
+        std::chrono::nanoseconds GetPercentile(double q) const;
+        std::chrono::nanoseconds GetMax() const;
+
+    private:
+        static constexpr size_t BUCKETS_PER_DOUBLING = 8;
+        //up to 2^40 ns, about 18 minutes
+        static constexpr size_t BUCKET_COUNT = 40 * BUCKETS_PER_DOUBLING + 1;
+
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+        std::atomic<uint64_t> count_{ 0 };
+        std::atomic<int64_t> max_{ 0 };
+    };
+
+    struct PhaseTime {
+        std::string name;
+        uint64_t count = 0;
+        std::chrono::nanoseconds total{ 0 };
+    };
+
+    // Process-wide timings of the run. Nothing is collected until Enable is called,
+    // the instrumented code only checks IsEnabled when it is off
+    class Metrics {
+    public:
+        static Metrics& Get();
+
+        void Enable();
+        bool IsEnabled() const {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        void AddPhase(std::string_view name, std::chrono::nanoseconds duration);
+        //histogram of the name, created on first use; the reference stays valid
+        LatencyHistogram& GetHistogram(std::string_view name);
+        //a decision taken during the run, a later note of the same name replaces it
+        void SetNote(std::string_view name, std::string text);
+
+        //phases in the order they were first seen
+        std::vector<PhaseTime> GetPhases() const;
+        //histograms in the order they were created
+        std::vector<std::pair<std::string, const LatencyHistogram*>> GetHistograms() const;
+        //notes in the order they were first set
+        std::vector<std::pair<std::string, std::string>> GetNotes() const;
+
+    private:
+        std::atomic<bool> enabled_{ false };
+        mutable std::mutex mutex_;
+        std::vector<PhaseTime> phases_;
+        std::deque<std::pair<std::string, LatencyHistogram>> histograms_;
+        std::vector<std::pair<std::string, std::string>> notes_;
+    };
+
+    // Adds the wall time of its scope to a phase of the metrics if they are enabled
+    class ScopedPhase {
+    public:
+        explicit ScopedPhase(std::string_view name)
+            : name_(name), enabled_(Metrics::Get().IsEnabled()) {
+            if (enabled_) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ScopedPhase() {
+            if (enabled_) {
+                Metrics::Get().AddPhase(name_, std::chrono::steady_clock::now() - start_);
+            }
+        }
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        std::string_view name_;
+        bool enabled_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "thread_pool.h"
+
+namespace util {
+
+    namespace {
+
+        //pool and queue of the worker running on this thread, if any
+        thread_local const ThreadPool* current_pool = nullptr;
+        thread_local size_t current_queue = 0;
+
+        struct ParallelForState {
+            const std::function<void(size_t)>* body;
+            size_t count;
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            //runs items until there are none left, returns when nothing is claimed
+            void Run() {
+                size_t completed = 0;
+                for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                    try {
+                        (*body)(i);
+                    }
+                    catch (...) {
+                        std::lock_guard lock(mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                    ++completed;
+                }
+                if (completed && done.fetch_add(completed) + completed == count) {
+                    std::lock_guard lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        };
+
+    }
+
+    ThreadPool::ThreadPool(size_t thread_count) {
+        thread_count = std::max<size_t>(thread_count, 1);
+        queues_.reserve(thread_count);
+        for (size_t i = 0; i != thread_count; ++i) {
+            queues_.push_back(std::make_unique<TaskQueue>());
+        }
+        workers_.reserve(thread_count);
+        for (size_t i = 0; i != thread_count; ++i) {
+            workers_.emplace_back([this, i] { Work(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        has_task_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::GetThreadCount() const {
+        return workers_.size();
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+        if (count == 0) {
+            return;
+        }
+        auto state = std::make_shared<ParallelForState>();
+        state->body = &body;
+        state->count = count;
+
+        //helpers that start after all items are claimed return at once without touching body
+        const size_t helpers = std::min(count, workers_.size() + 1) - 1;
+        for (size_t i = 0; i != helpers; ++i) {
+            Submit([state] { state->Run(); });
+        }
+        state->Run();
+
+        std::unique_lock lock(state->mutex);
+        state->finished.wait(lock, [&state] { return state->done.load() == state->count; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task) {
+        size_t index;
+        if (current_pool == this) {
+            index = current_queue;
+        }
+        else {
+            std::lock_guard lock(mutex_);
+            index = next_queue_++ % queues_.size();
+        }
+        {
+            std::lock_guard lock(queues_[index]->mutex);
+            queues_[index]->tasks.emplace_back(std::move(task));
+        }
+        {
+            std::lock_guard lock(mutex_);
+            ++pending_;
+        }
+        has_task_.notify_one();
+    }
+
+    void ThreadPool::Work(size_t index) {
+        current_pool = this;
+        current_queue = index;
+        while (true) {
+            {
+                std::unique_lock lock(mutex_);
+                has_task_.wait(lock, [this] { return stop_ || pending_ != 0; });
+                if (pending_ == 0) {
+                    return;
+                }
+                --pending_;
+            }
+            TakeTask(index)();
+        }
+    }
+
+    std::function<void()> ThreadPool::TakeTask(size_t index) {
+        //there are at least as many queued tasks as claims, but other workers may empty
+        //a queue right after it was looked at, so the scan is repeated until it succeeds
+        while (true) {
+            {
+                TaskQueue& own = *queues_[index];
+                std::lock_guard lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    std::function<void()> task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return task;
+                }
+            }
+            for (size_t i = 1; i != queues_.size(); ++i) {
+                TaskQueue& victim = *queues_[(index + i) % queues_.size()];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    std::function<void()> task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return task;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    ThreadPool& GetSharedPool() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+}
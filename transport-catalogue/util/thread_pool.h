@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+    // Work-stealing pool: every worker has its own task queue. A task submitted from a
+    // worker goes to the back of that worker's queue, and the worker takes its newest
+    // task first; idle workers steal the oldest tasks from the other queues
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t GetThreadCount() const;
+
+        // Calls body(i) for every i in [0, count) on the pool and waits for all of them.
+        // The calling thread takes part in the work, so ParallelFor may be called from
+        // inside a task of the same pool. The first exception thrown by body is rethrown
+        void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    private:
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::thread> workers_;
+        std::vector<std::unique_ptr<TaskQueue>> queues_;
+        //tasks from outside the pool are spread over the queues in turn
+        size_t next_queue_ = 0;
+        //guards sleeping workers, pending_ counts submitted tasks nobody has claimed yet
+        std::mutex mutex_;
+        std::condition_variable has_task_;
+        size_t pending_ = 0;
+        bool stop_ = false;
+
+        void Submit(std::function<void()> task);
+        void Work(size_t index);
+        //takes a task claimed from pending_, the own queue is tried before stealing
+        std::function<void()> TakeTask(size_t index);
+    };
+
+    //pool shared by the whole process, created on first use
+    ThreadPool& GetSharedPool();
+
+}